@@ -0,0 +1,197 @@
+/**
+ * @file                    HD44780Bus.cpp
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Common interface of the transports (I2C, parallel GPIO, shift register) used to drive an HD44780
+ *                          LCD
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#include "HD44780Bus.h"
+
+// Constructors
+
+HD44780Bus::HD44780Bus() {
+    timer.start();
+}
+
+// public methods
+
+uint32_t
+HD44780Bus::get_bus_width() const {
+    return 4;
+}
+
+void
+HD44780Bus::send_buffer(const uint8_t *buf, uint32_t len, uint8_t isData) {
+
+    for (const uint8_t *ptr = buf; ptr != &buf[len]; ++ptr) {
+        send_byte(*ptr, isData);
+    }
+}
+
+bool
+HD44780Bus::is_readable() const {
+    return true;
+}
+
+uint8_t
+HD44780Bus::read_status() {
+
+    if (!is_readable()) {
+        return 0;
+    }
+
+    commit();
+    wait_ready();
+
+    const uint8_t status = poll_status();
+
+    // the status of a transport that failed (until the LCD is resynchronized) can not be trusted
+    return faulted ? 0 : status;
+}
+
+void
+HD44780Bus::set_busy_polling(bool enable) {
+    busyPolling = enable && is_readable();
+}
+
+bool
+HD44780Bus::is_busy_polling() const {
+    return busyPolling;
+}
+
+void
+HD44780Bus::begin_batch() {
+}
+
+void
+HD44780Bus::end_batch(bool repeated) {
+    (void)repeated;
+}
+
+bool
+HD44780Bus::has_pending() const {
+    return false;
+}
+
+#if DEVICE_I2C_ASYNCH
+void
+HD44780Bus::end_batch_async(Callback<void(int)> done) {
+
+    end_batch();
+
+    if (done) {
+        done(I2C_EVENT_TRANSFER_COMPLETE);
+    }
+}
+#endif // DEVICE_I2C_ASYNCH
+
+void
+HD44780Bus::wait_transfer() {
+}
+
+void
+HD44780Bus::suspend() {
+
+    wait_ready();
+    timer.stop();
+}
+
+void
+HD44780Bus::resume() {
+    timer.start();
+}
+
+bool
+HD44780Bus::has_fault() const {
+    return faulted;
+}
+
+bool
+HD44780Bus::take_fault() {
+
+    const bool fault = faulted;
+
+    faulted = false;
+    return fault;
+}
+
+void
+HD44780Bus::reset_bus() {
+}
+
+#if HD44780LCD_ENABLE_STATS
+const HD44780Bus::Stats &
+HD44780Bus::get_stats() const {
+    return stats;
+}
+
+void
+HD44780Bus::reset_stats() {
+    stats = {};
+}
+#endif // HD44780LCD_ENABLE_STATS
+
+// protected methods
+
+void
+HD44780Bus::commit(bool repeated) {
+    (void)repeated;
+}
+
+void
+HD44780Bus::wait_ready() {
+
+    wait_transfer();
+
+    auto remaining = readyAt - timer.elapsed_time();
+
+    // polling is limited to instructions that take longer than a status read, the time taken by the
+    // transfers themselves covers the rest, if the flag never clears, fall back to waiting twice as long
+    if (busyPolling && remaining > EXEC_TIME) {
+
+        const auto timeout = readyAt + remaining;
+        while (!faulted && timer.elapsed_time() < timeout) {
+
+            if ((poll_status() & BUSY_FLAG) == 0) {
+                break;
+            }
+        }
+
+        if (!faulted) {
+
+            readyAt = timer.elapsed_time();
+            return;
+        }
+
+        // a status that could not be read says nothing about the LCD, so the rest of the execution time is waited out
+        remaining = readyAt - timer.elapsed_time();
+    }
+
+    // sleep through most of a long wait to let other threads run (the RTOS tick may end the first
+    // millisecond early), and busy-wait for the rest to stay accurate
+    if (remaining >= 2ms) {
+
+        ThisThread::sleep_for(std::chrono::duration_cast<std::chrono::milliseconds>(remaining) - 1ms);
+        remaining = readyAt - timer.elapsed_time();
+    }
+
+    if (remaining > 0us) {
+        wait_us(remaining.count());
+    }
+}
+
+void
+HD44780Bus::set_fault() {
+    faulted = true;
+}
+
+void
+HD44780Bus::mark_busy(std::chrono::microseconds execTime) {
+
+    // the LCD starts executing on the falling edge of EN, which ends the last transfer
+    readyAt = timer.elapsed_time() + execTime;
+}
@@ -0,0 +1,399 @@
+/**
+ * @file                    HD44780Bus.h
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Common interface of the transports (I2C, parallel GPIO, shift register) used to drive an HD44780
+ *                          LCD
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#ifndef __HD44780BUS_H__
+#define __HD44780BUS_H__
+
+#include "mbed.h"
+
+#ifndef HD44780LCD_ENABLE_STATS
+/** Whether the transports count their transfers and the time spent blocked in them (see ```HD44780LCD::get_stats()```) */
+#define HD44780LCD_ENABLE_STATS         0
+#endif
+
+/**
+ * @brief                   Class that provides the interface through which ```HD44780LCD``` talks to the LCD, along with
+ *                          the tracking of the execution time of each transfer that is common to all transports
+ *
+ * @remark                  Transports implement the transfer of bytes and nibbles, the backlight and (optionally) the
+ *                          read-back of the status, the batching methods are only implemented by transports that can
+ *                          pack transfers together (such as I2C)
+ *
+ * @remark                  Separate instances do not share any state (other than the bus they might be connected to), so
+ *                          they can be used from separate threads without any locking
+ *
+ */
+class HD44780Bus {
+
+public:
+
+    /**
+     * @brief               Counters of the transfers made by a transport and of the time spent blocked in them, kept
+     *                      when ```HD44780LCD_ENABLE_STATS``` is defined to 1
+     *
+     */
+    struct Stats {
+
+        /** Number of instructions sent (including the nibbles of the initialization sequence) */
+        uint32_t    instructions;
+        /** Number of data bytes (characters and CGRAM patterns) sent */
+        uint32_t    dataBytes;
+        /** Number of writes made on the bus (I2C transactions, only counted by the I2C transport) */
+        uint32_t    writes;
+        /** Number of writes that failed (NACKed or otherwise returned an error) */
+        uint32_t    errors;
+        /** Total time spent blocked in sending bytes, nibbles and batches, in microseconds */
+        uint64_t    blockedUs;
+        /** Longest time spent blocked in a single send, in microseconds */
+        uint32_t    maxBlockedUs;
+    };
+
+private:
+
+    /** Timer used to keep track of when the LCD finishes executing the last instruction */
+    Timer       timer;
+    /** Time (relative to ```timer```) at which the LCD will be ready to accept the next instruction */
+    std::chrono::microseconds   readyAt {0};
+    /** Whether the busy flag is polled (instead of waiting for the complete execution time) */
+    bool        busyPolling {false};
+    /** Whether a transfer has failed since the fault was last taken (the LCD may be out of sync) */
+    bool        faulted {false};
+
+#if HD44780LCD_ENABLE_STATS
+    /** Counters of the transfers made so far */
+    Stats       stats {};
+#endif // HD44780LCD_ENABLE_STATS
+
+public:
+
+    /** time taken by the LCD to execute most instructions and data writes (datasheet value, fosc = 270kHz) */
+    static constexpr std::chrono::microseconds  EXEC_TIME       {37};
+    /** time taken by the LCD to execute the clear display and return home instructions (datasheet value, fosc = 270kHz) */
+    static constexpr std::chrono::microseconds  LONG_EXEC_TIME  {1520};
+
+    /** mask of the busy flag in the status read from the LCD */
+    static constexpr uint8_t    BUSY_FLAG       = 0x80;
+
+protected:
+
+    /**
+     * @brief               Construct a new HD44780Bus object, starting the timer
+     *
+     */
+    HD44780Bus();
+
+    /**
+     * @brief               Send the transfers collected so far (if any), without ending the batch
+     *
+     * @param repeated      Whether to end the transaction without releasing the bus (such as with a repeated start)
+     */
+    virtual void    commit(bool repeated = false);
+
+    /**
+     * @brief               Block until the LCD has finished executing the last instruction sent to it (after the
+     *                      asynchronous transfer in progress, if any)
+     *
+     */
+    void            wait_ready();
+
+    /**
+     * @brief               Record that the LCD has just started executing an instruction
+     *
+     * @param execTime      Time the LCD takes to execute the instruction
+     */
+    void            mark_busy(std::chrono::microseconds execTime);
+
+    /**
+     * @brief               Read the busy flag and address counter of the LCD without waiting for it to be ready
+     *
+     * @remark              A read that fails must be recorded with ```set_fault()```, after which the execution times
+     *                      are waited out instead of polling the busy flag until the fault is taken
+     *
+     * @return uint8_t      Busy flag in the most significant bit, address counter in the remaining bits
+     */
+    virtual uint8_t poll_status() = 0;
+
+    /**
+     * @brief               Record that a transfer has failed, so that the LCD resynchronizes with the transport
+     *
+     */
+    void            set_fault();
+
+    /**
+     * @brief               Get the time at which a send begins, to be passed to ```count_blocked()``` once it returns
+     *
+     * @return std::chrono::microseconds Current time (0 if the counters are disabled)
+     */
+    std::chrono::microseconds   stats_begin() const {
+
+#if HD44780LCD_ENABLE_STATS
+        return timer.elapsed_time();
+#else
+        return std::chrono::microseconds {0};
+#endif // HD44780LCD_ENABLE_STATS
+    }
+
+    /**
+     * @brief               Count the time spent blocked in a send (does nothing if the counters are disabled)
+     *
+     * @param begin         Time at which the send began (as returned by ```stats_begin()```)
+     */
+    void            count_blocked(std::chrono::microseconds begin) {
+
+#if HD44780LCD_ENABLE_STATS
+        const uint32_t blocked = (timer.elapsed_time() - begin).count();
+
+        stats.blockedUs += blocked;
+        if (blocked > stats.maxBlockedUs) {
+            stats.maxBlockedUs = blocked;
+        }
+#else
+        (void)begin;
+#endif // HD44780LCD_ENABLE_STATS
+    }
+
+    /**
+     * @brief               Count bytes sent to the LCD (does nothing if the counters are disabled)
+     *
+     * @param isData        Whether the bytes are data or instructions
+     * @param count         Number of bytes
+     */
+    void            count_bytes(uint8_t isData, uint32_t count) {
+
+#if HD44780LCD_ENABLE_STATS
+        if (isData) {
+            stats.dataBytes += count;
+        }
+        else {
+            stats.instructions += count;
+        }
+#else
+        (void)isData;
+        (void)count;
+#endif // HD44780LCD_ENABLE_STATS
+    }
+
+    /**
+     * @brief               Count a write made on the bus (does nothing if the counters are disabled)
+     *
+     * @param result        Value returned by the write (non-zero on failure)
+     */
+    void            count_write(int result) {
+
+#if HD44780LCD_ENABLE_STATS
+        ++stats.writes;
+        if (result != 0) {
+            ++stats.errors;
+        }
+#else
+        (void)result;
+#endif // HD44780LCD_ENABLE_STATS
+    }
+
+public:
+
+    HD44780Bus(const HD44780Bus &) = delete;
+
+    virtual ~HD44780Bus() = default;
+
+    /**
+     * @brief               Get the number of data pins of the LCD driven by the transport
+     *
+     * @return uint32_t     4 (half-bus mode) or 8 (full-bus mode)
+     */
+    virtual uint32_t get_bus_width() const;
+
+    /**
+     * @brief               Send a byte (data or instruction) to the LCD
+     *
+     * @param byte          Byte to send (data or instruction indicated by ```isData```)
+     * @param isData        Whether the byte was data or an instruction
+     * @param execTime      Time the LCD takes to execute the byte, subsequent transfers are delayed until it elapses
+     */
+    virtual void    send_byte(uint8_t byte, uint8_t isData, std::chrono::microseconds execTime = EXEC_TIME) = 0;
+
+    /**
+     * @brief               Send an array of bytes (data or instructions) to the LCD
+     *
+     * @remark              The default implementation sends the bytes one at a time
+     *
+     * @param buf           Pointer to array of bytes
+     * @param len           Number of bytes to pick from the buffer
+     * @param isData        Whether the bytes are data or instructions
+     */
+    virtual void    send_buffer(const uint8_t *buf, uint32_t len, uint8_t isData);
+
+    /**
+     * @brief               Send a nibble (the upper 4 bits of an instruction, with the lower data pins low in full-bus
+     *                      mode) to the LCD, as used by the initialization sequence
+     *
+     * @param nibble        Nibble to send (data or instruction indicated by ```isData```)
+     * @param isData        Whether the byte was data or an instruction
+     * @param execTime      Time the LCD takes to execute the nibble, subsequent transfers are delayed until it elapses
+     */
+    virtual void    send_nibble(uint8_t nibble, uint8_t isData, std::chrono::microseconds execTime = EXEC_TIME) = 0;
+
+    /**
+     * @brief               Enable the LCD's backlight
+     *
+     */
+    virtual void    enable_backlight() = 0;
+
+    /**
+     * @brief               Disable the LCD's backlight
+     *
+     */
+    virtual void    disable_backlight() = 0;
+
+    /**
+     * @brief               Toggle the LCD's backlight
+     *
+     */
+    virtual void    toggle_backlight() = 0;
+
+    /**
+     * @brief               Check the state of the LCD's backlight
+     *
+     * @return              true if the backlight is switched on, false otherwise
+     */
+    virtual bool    is_backlight_on() const = 0;
+
+    /**
+     * @brief               Check whether the transport can read from the LCD (requires the RW pin to be connected)
+     *
+     * @return              true if the status can be read, false otherwise
+     */
+    virtual bool    is_readable() const;
+
+    /**
+     * @brief               Wait for the LCD to be ready and read its busy flag and address counter
+     *
+     * @return uint8_t      Busy flag in the most significant bit, address counter in the remaining bits (0 if the
+     *                      transport can not read from the LCD, or if the read failed and was recorded as a fault)
+     */
+    uint8_t         read_status();
+
+    /**
+     * @brief               Enable or disable polling the busy flag while waiting for the LCD to execute an instruction
+     *                      (ignored if the transport can not read from the LCD)
+     *
+     * @param enable        Whether the busy flag should be polled
+     */
+    void            set_busy_polling(bool enable);
+
+    /**
+     * @brief               Check whether the busy flag is polled while waiting for the LCD to execute an instruction
+     *
+     * @return              true if the busy flag is polled, false otherwise
+     */
+    bool            is_busy_polling() const;
+
+    /**
+     * @brief               Start collecting subsequent transfers (except those that take long to execute) into a single
+     *                      transaction on the bus
+     *
+     * @remark              The default implementation sends every transfer immediately
+     *
+     */
+    virtual void    begin_batch();
+
+    /**
+     * @brief               Stop collecting transfers and send the ones that have been collected
+     *
+     * @param repeated      Whether to end the transaction without releasing the bus (such as with a repeated start)
+     */
+    virtual void    end_batch(bool repeated = false);
+
+    /**
+     * @brief               Check whether any transfers have been collected but not sent yet
+     *
+     * @return true         If transfers are waiting to be sent
+     * @return false        Otherwise
+     */
+    virtual bool    has_pending() const;
+
+#if DEVICE_I2C_ASYNCH
+    /**
+     * @brief               Stop collecting transfers and start sending the ones that have been collected in the
+     *                      background, returning immediately
+     *
+     * @remark              The default implementation sends them from the calling thread and invokes the callback
+     *                      before returning
+     *
+     * @param done          Callback to invoke with the I2C events once the transfer completes
+     */
+    virtual void    end_batch_async(Callback<void(int)> done);
+#endif // DEVICE_I2C_ASYNCH
+
+    /**
+     * @brief               Wait for the asynchronous transfer in progress (if any) to complete
+     *
+     */
+    virtual void    wait_transfer();
+
+    /**
+     * @brief               Wait for the LCD to be ready and stop the timer (so that it does not keep the
+     *                      microcontroller out of deep sleep)
+     *
+     */
+    void            suspend();
+
+    /**
+     * @brief               Restart the timer stopped by ```suspend()```
+     *
+     */
+    void            resume();
+
+    /**
+     * @brief               Check whether a transfer has failed since the fault was last taken, without clearing it
+     *
+     * @return true         If a transfer has failed
+     * @return false        Otherwise
+     */
+    bool            has_fault() const;
+
+    /**
+     * @brief               Check whether a transfer has failed since the last call (such as an I2C write that was not
+     *                      acknowledged), clearing the fault
+     *
+     * @remark              A failed transfer may have been partially latched by the LCD, which leaves it out of sync
+     *                      with the transport until it is resynchronized (in half-bus mode)
+     *
+     * @return true         If a transfer has failed
+     * @return false        Otherwise
+     */
+    bool            take_fault();
+
+    /**
+     * @brief               Reset the bus after transfers have failed, before the LCD is resynchronized
+     *
+     * @remark              The default implementation does nothing
+     *
+     */
+    virtual void    reset_bus();
+
+#if HD44780LCD_ENABLE_STATS
+    /**
+     * @brief               Get the counters of the transfers made since construction (or the last reset)
+     *
+     * @return const Stats& Counters of the transport
+     */
+    const Stats     &get_stats() const;
+
+    /**
+     * @brief               Reset all counters to zero
+     *
+     */
+    void            reset_stats();
+#endif // HD44780LCD_ENABLE_STATS
+};
+
+#endif //__HD44780BUS_H__
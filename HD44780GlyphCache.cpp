@@ -0,0 +1,261 @@
+/**
+ * @file                    HD44780GlyphCache.cpp
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Cache that maps a large table of custom characters onto the 8 CGRAM slots of an HD44780 LCD
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#include "HD44780GlyphCache.h"
+
+// Constructors
+
+HD44780GlyphCache::HD44780GlyphCache(HD44780LCD &lcd, const uint8_t glyphs[][8], uint32_t glyphCount,
+        uint8_t fallback)
+        : lcd {lcd}
+        , glyphs {glyphs}
+        , glyphCount {(glyphCount < NO_GLYPH) ? glyphCount : NO_GLYPH}
+        , fallback {fallback}
+{
+    for (auto &glyph : slotGlyph) {
+        glyph = NO_GLYPH;
+    }
+
+    for (uint32_t idx = 0; idx < MAX_CELLS; ++idx) {
+
+        cellGlyph[idx] = NO_GLYPH;
+        cellCode[idx] = NO_CODE;
+    }
+}
+
+// public methods
+
+void
+HD44780GlyphCache::draw_glyph(const uint32_t r, const uint32_t c, const uint32_t id) {
+
+    if (r >= lcd.get_row_count() || c >= lcd.get_col_count() || id >= glyphCount) {
+        return;
+    }
+
+    auto idx = (r * lcd.get_col_count()) + c;
+
+    lcd.lock();
+
+    cellGlyph[idx] = id;
+    cellCode[idx] = NO_CODE;
+
+    lcd.unlock();
+}
+
+void
+HD44780GlyphCache::release_cell(const uint32_t r, const uint32_t c) {
+
+    if (r >= lcd.get_row_count() || c >= lcd.get_col_count()) {
+        return;
+    }
+
+    auto idx = (r * lcd.get_col_count()) + c;
+
+    lcd.lock();
+
+    cellGlyph[idx] = NO_GLYPH;
+    cellCode[idx] = NO_CODE;
+
+    lcd.unlock();
+}
+
+void
+HD44780GlyphCache::invalidate() {
+
+    lcd.lock();
+
+    for (uint32_t slot = 0; slot < SLOT_COUNT; ++slot) {
+
+        slotGlyph[slot] = NO_GLYPH;
+        slotUsed[slot] = 0;
+    }
+
+    // the cells are written again as well, since the DDRAM is usually lost along with the CGRAM
+    for (auto &code : cellCode) {
+        code = NO_CODE;
+    }
+
+    lcd.unlock();
+}
+
+void
+HD44780GlyphCache::flush() {
+
+    bool changed[SLOT_COUNT] {false};
+
+    // the uploads and redraws are sent as a single batch, without commands of other threads in between (which could
+    // move the address counter between selecting a slot and writing its pattern), and the guard flushes the LCD if
+    // buffering is enabled on it
+    HD44780LCD::Transaction transaction(lcd);
+
+    release_overwritten_cells();
+    assign_slots(changed);
+    upload_slots(changed);
+    redraw_cells();
+}
+
+int32_t
+HD44780GlyphCache::get_slot(const uint32_t id) const {
+
+    if (id >= glyphCount) {
+        return -1;
+    }
+
+    return find_slot(id);
+}
+
+// private methods
+
+int32_t
+HD44780GlyphCache::find_slot(uint16_t id) const {
+
+    for (uint32_t slot = 0; slot < SLOT_COUNT; ++slot) {
+        if (slotGlyph[slot] == id) {
+            return slot;
+        }
+    }
+
+    return -1;
+}
+
+void
+HD44780GlyphCache::release_overwritten_cells() {
+
+    const uint32_t cols = lcd.get_col_count();
+    const uint32_t cells = lcd.get_row_count() * cols;
+
+    for (uint32_t idx = 0; idx < cells; ++idx) {
+
+        if (cellGlyph[idx] == NO_GLYPH || cellCode[idx] == NO_CODE) {
+            continue;
+        }
+
+        if (lcd.get_char_at(idx / cols, idx % cols) != cellCode[idx]) {
+
+            cellGlyph[idx] = NO_GLYPH;
+            cellCode[idx] = NO_CODE;
+        }
+    }
+}
+
+void
+HD44780GlyphCache::assign_slots(bool changed[SLOT_COUNT]) {
+
+    const uint32_t cells = lcd.get_row_count() * lcd.get_col_count();
+
+    ++flushCount;
+
+    // glyphs that already hold a slot keep it, so that slot can not be evicted by the glyphs that follow
+    for (uint32_t idx = 0; idx < cells; ++idx) {
+
+        if (cellGlyph[idx] == NO_GLYPH) {
+            continue;
+        }
+
+        auto slot = find_slot(cellGlyph[idx]);
+        if (slot >= 0) {
+            slotUsed[slot] = flushCount;
+        }
+    }
+
+    for (uint32_t idx = 0; idx < cells; ++idx) {
+
+        uint16_t id = cellGlyph[idx];
+        if (id == NO_GLYPH || find_slot(id) >= 0) {
+            continue;
+        }
+
+        // the least recently used slot that is not needed by this flush is evicted (empty slots are taken first)
+        int32_t victim = -1;
+        for (uint32_t slot = 0; slot < SLOT_COUNT; ++slot) {
+
+            if (slotUsed[slot] == flushCount) {
+                continue;
+            }
+            if (victim < 0 || slotUsed[slot] < slotUsed[victim]) {
+                victim = slot;
+            }
+        }
+
+        // all slots are taken by glyphs on the display, so this glyph is shown as the fallback character
+        if (victim < 0) {
+            continue;
+        }
+
+        // a glyph with the same pattern as the evicted one does not need to be uploaded
+        auto old = slotGlyph[victim];
+        if (old == NO_GLYPH || memcmp(glyphs[old], glyphs[id], sizeof(glyphs[id])) != 0) {
+            changed[victim] = true;
+        }
+
+        slotGlyph[victim] = id;
+        slotUsed[victim] = flushCount;
+    }
+}
+
+void
+HD44780GlyphCache::upload_slots(const bool changed[SLOT_COUNT]) {
+
+    uint8_t patterns[SLOT_COUNT][8];
+
+    for (uint32_t first = 0; first < SLOT_COUNT; ) {
+
+        if (!changed[first]) {
+            ++first;
+            continue;
+        }
+
+        uint32_t count = 0;
+        while ((first + count) < SLOT_COUNT && changed[first + count]) {
+
+            memcpy(patterns[first + count], glyphs[slotGlyph[first + count]], sizeof(patterns[0]));
+            ++count;
+        }
+
+        lcd.load_glyphs(first, count, &patterns[first]);
+        first += count;
+    }
+}
+
+void
+HD44780GlyphCache::redraw_cells() {
+
+    const uint32_t cols = lcd.get_col_count();
+    const uint32_t cells = lcd.get_row_count() * cols;
+
+    const auto row = lcd.get_cursor_row();
+    const auto col = lcd.get_cursor_col();
+
+    bool moved = false;
+
+    for (uint32_t idx = 0; idx < cells; ++idx) {
+
+        if (cellGlyph[idx] == NO_GLYPH) {
+            continue;
+        }
+
+        auto slot = find_slot(cellGlyph[idx]);
+        uint8_t code = (slot >= 0) ? slot : fallback;
+
+        if (cellCode[idx] == code) {
+            continue;
+        }
+
+        lcd.set_cursor_pos(idx / cols, idx % cols);
+        lcd.send_data(code);
+
+        cellCode[idx] = code;
+        moved = true;
+    }
+
+    if (moved) {
+        lcd.set_cursor_pos(row, col);
+    }
+}
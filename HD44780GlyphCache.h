@@ -0,0 +1,185 @@
+/**
+ * @file                    HD44780GlyphCache.h
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Cache that maps a large table of custom characters onto the 8 CGRAM slots of an HD44780 LCD
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#ifndef __HD44780GLYPHCACHE_H__
+#define __HD44780GLYPHCACHE_H__
+
+#include "HD44780LCD.h"
+
+/**
+ * @brief                   Class that lets more than 8 custom characters (glyphs) be drawn on an LCD, by assigning the
+ *                          glyphs present on the display to the CGRAM slots of the LCD on each flush
+ *
+ * @remark                  Glyphs are drawn by their index in a table (which can be stored in flash), and the slots are
+ *                          reassigned in least-recently-used order, such that only slots whose contents change are
+ *                          uploaded again
+ *
+ * @remark                  If more than 8 different glyphs are on the display at once, the ones in the last cells (in
+ *                          row-major order) are shown as a fallback character until a slot becomes available
+ *
+ * @remark                  Cells are written with the cursor auto-increment entry mode in mind, the display auto-shift
+ *                          entry modes would scroll the display on each write
+ *
+ * @remark                  Every method that changes the cache locks the LCD (which is not done in ISR context), and a
+ *                          flush is sent as a single ```HD44780LCD::Transaction```, so a cache can be shared by threads
+ *                          that also use the LCD directly
+ *
+ */
+class HD44780GlyphCache {
+
+    /** Number of CGRAM slots of the LCD */
+    static constexpr uint32_t   SLOT_COUNT  = 8;
+    /** Maximum number of cells on the display (20x4 and 40x2 modules) */
+    static constexpr uint32_t   MAX_CELLS   = 80;
+
+    /** Value denoting that a slot or a cell does not hold any glyph */
+    static constexpr uint16_t   NO_GLYPH    = 0xffff;
+    /** Value denoting that a cell holds a glyph which has not been written to the LCD yet */
+    static constexpr uint16_t   NO_CODE     = 0xffff;
+
+    /** LCD on which the glyphs are drawn */
+    HD44780LCD      &lcd;
+
+    /** Patterns of the glyphs that can be drawn */
+    const uint8_t   (*glyphs)[8];
+    /** Number of glyphs in ```glyphs``` */
+    uint32_t        glyphCount;
+    /** Character shown in place of glyphs that could not be assigned a slot */
+    uint8_t         fallback;
+
+    /** Glyph held by each slot in the CGRAM of the LCD */
+    uint16_t        slotGlyph[SLOT_COUNT];
+    /** Flush on which each slot was last needed (for least-recently-used eviction) */
+    uint32_t        slotUsed[SLOT_COUNT] {0};
+    /** Number of flushes performed so far */
+    uint32_t        flushCount {0};
+
+    /** Glyph drawn in each cell of the display (row-major) */
+    uint16_t        cellGlyph[MAX_CELLS];
+    /** Character last written to each cell holding a glyph (slot or fallback) */
+    uint16_t        cellCode[MAX_CELLS];
+
+    /**
+     * @brief               Get the slot holding a glyph
+     *
+     * @param id            Index of the glyph
+     * @return int32_t      Slot holding the glyph, -1 if none
+     */
+    int32_t         find_slot(uint16_t id) const;
+
+    /**
+     * @brief               Forget the glyphs in cells that have been overwritten directly on the LCD since the last flush
+     *
+     */
+    void            release_overwritten_cells();
+
+    /**
+     * @brief               Assign slots to the glyphs on the display that do not have one, evicting the least recently
+     *                      used glyphs that are no longer on the display
+     *
+     * @param changed       Set to true for each slot whose glyph changes
+     */
+    void            assign_slots(bool changed[SLOT_COUNT]);
+
+    /**
+     * @brief               Upload the patterns of the slots whose glyph changed, using one transaction per run of
+     *                      consecutive slots
+     *
+     * @param changed       Whether the glyph in each slot changed
+     */
+    void            upload_slots(const bool changed[SLOT_COUNT]);
+
+    /**
+     * @brief               Write the character code of their glyph to the cells whose code changed
+     *
+     */
+    void            redraw_cells();
+
+public:
+
+    HD44780GlyphCache() = delete;
+
+    HD44780GlyphCache(const HD44780GlyphCache &) = delete;
+
+    /**
+     * @brief               Construct a new HD44780GlyphCache object
+     *
+     * @param lcd           LCD on which the glyphs are drawn (must not be used by another glyph cache)
+     * @param glyphs        Patterns of the glyphs that can be drawn (must outlive the cache)
+     * @param glyphCount    Number of glyphs in ```glyphs``` (up to 65535)
+     * @param fallback      Character shown in place of glyphs that could not be assigned a slot
+     *
+     */
+    HD44780GlyphCache(HD44780LCD &lcd, const uint8_t glyphs[][8], uint32_t glyphCount, uint8_t fallback = ' ');
+
+    /**
+     * @brief               Draw a glyph in a cell of the display
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @remark              The glyph is only written to the LCD by ```HD44780GlyphCache::flush()```, and stays in the
+     *                      cell until it is overwritten (either by the cache or directly on the LCD)
+     *
+     * @attention           This method can be called from ISR context
+     * @attention           This method can be called from multiple threads concurrently
+     *
+     * @param r             Row of the cell
+     * @param c             Column of the cell (must be a visible column)
+     * @param id            Index of the glyph in the table, glyphs outside the table are ignored
+     */
+    void            draw_glyph(const uint32_t r, const uint32_t c, const uint32_t id);
+
+    /**
+     * @brief               Stop tracking the glyph in a cell of the display, so that it no longer holds a slot
+     *
+     * @remark              This method does not alter the contents of the cell
+     *
+     * @attention           This method can be called from ISR context
+     * @attention           This method can be called from multiple threads concurrently
+     *
+     * @param r             Row of the cell
+     * @param c             Column of the cell
+     */
+    void            release_cell(const uint32_t r, const uint32_t c);
+
+    /**
+     * @brief               Forget the contents of all slots, such that they are uploaded again on the next flush
+     *
+     * @remark              Must be called after the LCD is initialized again (which does not preserve the CGRAM), or
+     *                      after the CGRAM is written directly
+     *
+     * @attention           This method can be called from ISR context
+     * @attention           This method can be called from multiple threads concurrently
+     */
+    void            invalidate();
+
+    /**
+     * @brief               Assign slots to the glyphs on the display, upload the slots whose glyph changed, write the
+     *                      cells whose slot changed and flush the LCD (if buffering is enabled on it)
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @attention           Can not call this method from ISR context
+     * @attention           This method can be called from multiple threads concurrently
+     */
+    void            flush();
+
+    /**
+     * @brief               Get the slot currently holding a glyph
+     *
+     * @attention           This method can be called from ISR context
+     *
+     * @param id            Index of the glyph
+     * @return int32_t      Slot (character code) holding the glyph, -1 if the glyph does not hold a slot
+     */
+    int32_t         get_slot(const uint32_t id) const;
+};
+
+#endif //__HD44780GLYPHCACHE_H__
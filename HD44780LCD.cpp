@@ -1,4 +1,5 @@
 #include "HD44780LCD.h"
+#include "HD44780Screen.h"
 
 /** get the lower nibble (4 least significant bits) of a byte */
 #define             LO_NIBBLE(x)          (((x) >> 0) & 0x0f)
@@ -64,6 +65,8 @@ constexpr uint8_t   LCD_BUS_SIZE_8      = 0x10;
 
 /** instruction to set the address in the CGRAM (where the subsequent data will be written to) */
 constexpr uint8_t   LCD_SET_CGRAMADDR   = 0x40;
+/** number of custom characters (glyphs of 8 rows) that can be stored in the CGRAM */
+constexpr uint32_t  LCD_GLYPH_COUNT     = 8;
 
 /** instruction to set the address in the DDRAM (where the subsequent data will be written to) */
 constexpr uint8_t   LCD_SET_DDRAMADDR   = 0x80;
@@ -74,472 +77,2707 @@ constexpr uint8_t   LCD_ORIG_ADDR_SINGLE= 0x00;
 constexpr uint8_t   LCD_ORIG_ADDR_FIRST = 0x00;
 /** address of the first position of the second line in two-line mode */
 constexpr uint8_t   LCD_ORIG_ADDR_SECOND= 0x40;
-/** the width of a single line of the LCD */
+/** the width of a single line of the LCD in two-line mode */
 constexpr uint8_t   LCD_LINE_SIZE       = 0x28;
+/** the width of the line of the LCD in single-line mode */
+constexpr uint8_t   LCD_LINE_SIZE_SINGLE= 0x50;
+
+/** mask of the address counter in the status read from the LCD */
+constexpr uint8_t   LCD_ADDR_COUNTER    = 0x7f;
+
+/** kind of a queued command that sends an instruction */
+constexpr uint16_t  ASYNC_INSTRUCTION   = 0x000;
+/** kind of a queued command that sends an instruction that takes long to execute (clear display/home) */
+constexpr uint16_t  ASYNC_LONG_INSTR    = 0x100;
+/** kind of a queued command that sends a data byte */
+constexpr uint16_t  ASYNC_DATA          = 0x200;
+/** kind of a queued command that switches the backlight on (if the byte is non-zero) or off */
+constexpr uint16_t  ASYNC_BACKLIGHT     = 0x300;
+/** kind of a queued command that begins or ends a batch (the byte is one of the ```BATCH_*``` markers) */
+constexpr uint16_t  ASYNC_BATCH         = 0x400;
+/** mask of the kind of a queued command (the byte being sent occupies the lower bits) */
+constexpr uint16_t  ASYNC_KIND_MASK     = 0x700;
+
+/** marker to end a batch and send the collected commands */
+constexpr uint8_t   BATCH_END           = 0;
+/** marker to begin collecting commands into a batch */
+constexpr uint8_t   BATCH_BEGIN         = 1;
+/** marker to end a batch and send the collected commands in the background */
+constexpr uint8_t   BATCH_END_ASYNC     = 2;
+
+/** thread flag used to wake the dedicated thread that drains the queue */
+constexpr uint32_t  ASYNC_DRAIN_FLAG    = 0x01;
+/** event flag used to signal the completion of an asynchronous I2C transfer */
+constexpr uint32_t  TRANSFER_DONE_FLAG  = 0x01;
+
+/** code point reported for invalid UTF-8 input */
+constexpr uint32_t  UTF8_INVALID        = 0xfffd;
+/** number of translated characters collected on the stack before they are sent */
+constexpr uint32_t  TRANSLATE_CHUNK     = 32;
+
+/**
+ * @brief               Range of consecutive code points shown by consecutive characters of a character ROM
+ *
+ */
+struct RomRange {
+
+    /** first code point of the range */
+    uint32_t    first;
+    /** last code point of the range (inclusive) */
+    uint32_t    last;
+    /** code of the character that shows the first code point */
+    uint8_t     code;
+};
+
+/** code points shown by the A00 (Japanese) ROM, sorted by code point */
+constexpr RomRange  ROM_A00[] = {
+    {0x0020, 0x005b, 0x20},     // ASCII up to '[' (0x5c shows the yen sign)
+    {0x005d, 0x007d, 0x5d},     // ASCII from ']' up to '}' (0x7e and 0x7f show arrows)
+    {0x00a2, 0x00a2, 0xec},     // cent sign
+    {0x00a5, 0x00a5, 0x5c},     // yen sign
+    {0x00b0, 0x00b0, 0xdf},     // degree sign (shown by the handakuten)
+    {0x00b5, 0x00b5, 0xe4},     // micro sign
+    {0x00e4, 0x00e4, 0xe1},     // a with diaeresis
+    {0x00f1, 0x00f1, 0xee},     // n with tilde
+    {0x00f6, 0x00f6, 0xef},     // o with diaeresis
+    {0x00f7, 0x00f7, 0xfd},     // division sign
+    {0x00fc, 0x00fc, 0xf5},     // u with diaeresis
+    {0x03a3, 0x03a3, 0xf6},     // capital sigma
+    {0x03a9, 0x03a9, 0xf4},     // capital omega
+    {0x03b1, 0x03b1, 0xe0},     // alpha
+    {0x03b2, 0x03b2, 0xe2},     // beta
+    {0x03b5, 0x03b5, 0xe3},     // epsilon
+    {0x03b8, 0x03b8, 0xf2},     // theta
+    {0x03bc, 0x03bc, 0xe4},     // mu
+    {0x03c0, 0x03c0, 0xf7},     // pi
+    {0x03c1, 0x03c1, 0xe6},     // rho
+    {0x03c3, 0x03c3, 0xe5},     // sigma
+    {0x2190, 0x2190, 0x7f},     // leftwards arrow
+    {0x2192, 0x2192, 0x7e},     // rightwards arrow
+    {0x221a, 0x221a, 0xe8},     // square root
+    {0x221e, 0x221e, 0xf3},     // infinity
+    {0x2588, 0x2588, 0xff},     // full block
+    {0x3001, 0x3001, 0xa4},     // ideographic comma
+    {0x3002, 0x3002, 0xa1},     // ideographic full stop
+    {0x300c, 0x300c, 0xa2},     // left corner bracket
+    {0x300d, 0x300d, 0xa3},     // right corner bracket
+    {0x30fb, 0x30fb, 0xa5},     // katakana middle dot
+    {0x30fc, 0x30fc, 0xb0},     // katakana prolonged sound mark
+    {0x4e07, 0x4e07, 0xfb},     // ten thousand
+    {0x5186, 0x5186, 0xfc},     // yen
+    {0x5343, 0x5343, 0xfa},     // thousand
+    {0xff61, 0xff9f, 0xa1},     // halfwidth punctuation and katakana (in the order of JIS X 0201)
+};
+
+/** code points shown by the A02 (European) ROM, sorted by code point */
+constexpr RomRange  ROM_A02[] = {
+    {0x0020, 0x007e, 0x20},     // ASCII
+    {0x00a1, 0x00a3, 0xa1},     // inverted exclamation mark, cent sign, pound sign
+    {0x00a5, 0x00a5, 0xa5},     // yen sign
+    {0x00a7, 0x00a7, 0xa7},     // section sign
+    {0x00b0, 0x00b3, 0xb0},     // degree sign, plus-minus sign, superscript two and three
+    {0x00b5, 0x00b5, 0xb5},     // micro sign
+    {0x00bf, 0x00ff, 0xbf},     // inverted question mark and the Latin-1 letters (in the order of ISO 8859-1)
+    {0x03bc, 0x03bc, 0xb5},     // mu
+    {0x2302, 0x2302, 0x7f},     // house
+};
+
+/**
+ * @brief               Check whether the ranges of a character ROM are sorted and do not overlap
+ *
+ * @param table         Ranges of the ROM
+ * @param count         Number of ranges
+ * @return true         If the ranges can be searched
+ * @return false        Otherwise
+ */
+constexpr bool
+rom_is_sorted(const RomRange *table, uint32_t count) {
+
+    for (uint32_t i = 0; i < count; ++i) {
+
+        if (table[i].last < table[i].first || (i != 0 && table[i].first <= table[i - 1].last)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(rom_is_sorted(ROM_A00, sizeof(ROM_A00) / sizeof(ROM_A00[0])), "ROM_A00 must be sorted");
+static_assert(rom_is_sorted(ROM_A02, sizeof(ROM_A02) / sizeof(ROM_A02[0])), "ROM_A02 must be sorted");
+
+/**
+ * @brief               Find the character of a ROM that shows a code point
+ *
+ * @param table         Ranges of the ROM (sorted)
+ * @param count         Number of ranges
+ * @param codepoint     Code point to find
+ * @return int32_t      Code of the character, or -1 if the ROM does not show the code point
+ */
+constexpr int32_t
+rom_lookup(const RomRange *table, uint32_t count, uint32_t codepoint) {
+
+    uint32_t lo = 0;
+    uint32_t hi = count;
+
+    while (lo < hi) {
+
+        uint32_t mid = (lo + hi) / 2;
+
+        if (codepoint < table[mid].first) {
+            hi = mid;
+        }
+        else if (codepoint > table[mid].last) {
+            lo = mid + 1;
+        }
+        else {
+            return table[mid].code + (codepoint - table[mid].first);
+        }
+    }
+
+    return -1;
+}
 
-/** the index of the bit that manages the RS pin of the LCD */
-constexpr uint8_t   RS_ID				= 0;
-/** the index of the bit that manages the RW pin of the LCD */
-constexpr uint8_t   RW_ID				= 1;
-/** the index of the bit that manages the EN pin of the LCD */
-constexpr uint8_t   EN_ID               = 2;
-/** the index of the bit that manages the backlight of the LCD */
-constexpr uint8_t   BACKLIGHT_ID        = 3;
+static_assert(rom_lookup(ROM_A00, sizeof(ROM_A00) / sizeof(ROM_A00[0]), 0xb0) == 0xdf, "degree sign");
+static_assert(rom_lookup(ROM_A00, sizeof(ROM_A00) / sizeof(ROM_A00[0]), 0xff9f) == 0xdf, "halfwidth katakana");
 
 // Constructors
 
-HD44780LCD::HD44780LCD(PinName i2c_sda, PinName i2c_scl)
-        : con(i2c_sda, i2c_scl)
-        , cursorLoc {LCD_ORIG_ADDR_FIRST}
-{}
+HD44780LCD::HD44780LCD(PinName i2c_sda, PinName i2c_scl, uint32_t frequency, uint8_t addr, const PinMap &pinMap)
+        : HD44780LCD(i2c_sda, i2c_scl, GEOMETRY_16X2, frequency, addr, pinMap)
+{
+}
+
+HD44780LCD::HD44780LCD(PinName i2c_sda, PinName i2c_scl, const Geometry &geometry, uint32_t frequency, uint8_t addr,
+        const PinMap &pinMap)
+        : i2c(std::in_place, i2c_sda, i2c_scl, addr, frequency, pinMap)
+        , con(*i2c)
+        , geometry {geometry}
+        , cursorLoc {geometry.address(0, 0)}
+{
+    clear_frame(true);
+}
+
+HD44780LCD::HD44780LCD(I2C &bus, uint8_t addr, const Geometry &geometry, const PinMap &pinMap)
+        : i2c(std::in_place, bus, addr, pinMap)
+        , con(*i2c)
+        , geometry {geometry}
+        , cursorLoc {geometry.address(0, 0)}
+{
+    clear_frame(true);
+}
+
+HD44780LCD::HD44780LCD(HD44780Bus &bus, const Geometry &geometry)
+        : con(bus)
+        , geometry {geometry}
+        , cursorLoc {geometry.address(0, 0)}
+{
+    clear_frame(true);
+}
+
+HD44780LCD::~HD44780LCD() {
+
+    disable_dimming();
+    disable_async();
+}
+
+HD44780LCD::Transaction::Transaction(HD44780LCD &lcd)
+        : lcd {lcd}
+{
+    lcd.lock();
+    lcd.write_batch(BATCH_BEGIN);
+}
+
+HD44780LCD::Transaction::~Transaction() {
+
+    if (lcd.buffered) {
+        lcd.write_frame_changes();
+    }
+
+    lcd.write_batch(BATCH_END);
+    lcd.unlock();
+}
 
 // public methods
 
 void
-HD44780LCD::initialize() {
+HD44780LCD::initialize(bool warm) {
 
-    ThisThread::sleep_for(50ms);
+    lock();
+    sync();
 
     displayState = LCD_DISPLAY_ENABLE | LCD_CURSOR_DISABLE | LCD_BLINK_DISABLE;
     cursorMovement = LCD_CURSOR_MOVE | LCD_CURSOR_POS_INC;
 
-    for (uint32_t i = 0; i < 3; ++i) {
+    if (!warm) {
+
+        // the LCD needs 40ms after power rises, most of which has usually passed by the time this runs
+        auto uptime = Kernel::Clock::now().time_since_epoch();
+        if (uptime < POWER_ON_TIME) {
+            ThisThread::sleep_for(std::chrono::duration_cast<std::chrono::milliseconds>(POWER_ON_TIME - uptime) + 1ms);
+        }
 
-        con.send_nibble(HI_NIBBLE(LCD_SET_FUNCTION | LCD_BUS_SIZE_8), 0);
-        ThisThread::sleep_for(5ms);
+        send_resync_sequence();
     }
 
-    con.send_nibble(HI_NIBBLE(LCD_SET_FUNCTION | LCD_BUS_SIZE_4), 0);
-    ThisThread::sleep_for(2ms);
+    con.send_byte(LCD_SET_FUNCTION | ((con.get_bus_width() == 8) ? LCD_BUS_SIZE_8 : LCD_BUS_SIZE_4) | LCD_DOT_COUNT_8
+            | (geometry.is_two_line() ? LCD_LINE_COUNT_2 : LCD_LINE_COUNT_1), 0);
 
-    con.send_byte(LCD_SET_FUNCTION | LCD_BUS_SIZE_4 | LCD_DOT_COUNT_8 | LCD_LINE_COUNT_2, 0);
-    ThisThread::sleep_for(2ms);
+    // clearing the display also returns it home, so the return home instruction is not needed
+    con.send_byte(LCD_CLEAR_DISPLAY, 0, LONG_EXEC_TIME);
+    clear_frame(true);
 
-    con.send_byte(LCD_CLEAR_DISPLAY, 0);
-    ThisThread::sleep_for(2ms);
+    con.send_byte(LCD_SET_ENTRY_MODE | cursorMovement, 0);
+    con.send_byte(LCD_CONTROL_DISPLAY | displayState, 0);
 
-    con.send_byte(LCD_SET_CURSOR_HOME, 0);
-    ThisThread::sleep_for(2ms);
+    // the sequence leaves the address counter at the start of the DDRAM, incrementing after each write
+    cursorLoc = geometry.address(0, 0);
+    addrCounter = LCD_ORIG_ADDR_FIRST;
+    addrCounterValid = true;
+    addrCounterInc = true;
 
-    con.send_byte(LCD_CONTROL_DISPLAY | displayState, 0);
-    ThisThread::sleep_for(2ms);
+    initialized = true;
 
-    con.send_byte(LCD_SET_ENTRY_MODE | cursorMovement, 0);
-    ThisThread::sleep_for(2ms);
-}
+    // a failure during the sequence is recovered by running it again
+    check_fault();
 
+    unlock();
+}
 
 void
-HD44780LCD::send_data(const uint8_t byte) {
+HD44780LCD::resync() {
 
-    con.send_byte(byte, 1);
+    lock();
 
-    (cursorMovement & LCD_CURSOR_POS_INC)
-    ? inc_cursor_loc()
-    : dec_cursor_loc();
-}
+    auto queue = asyncEvents;
+    const bool async = asyncEnabled;
 
-void
-HD44780LCD::send_buffer(const uint8_t *buf, const uint32_t len) {
+    // the queue is drained and the consumer stopped, so that the recovery has the transport to itself
+    disable_async();
 
-    for (const uint8_t *ptr = buf; ptr != &buf[len]; ++ptr) {
-        send_data(*ptr);
+    con.take_fault();
+    recover();
+
+    if (async) {
+        enable_async(queue);
     }
+
+    unlock();
 }
 
+
 void
-HD44780LCD::create_custom_char(const uint32_t loc, const uint8_t *glyph) {
+HD44780LCD::send_data(const uint8_t byte) {
 
-    con.send_byte(LCD_SET_CGRAMADDR | (loc << 3), 0);
+    lock();
 
-    for (const uint8_t *ptr = glyph; ptr != &glyph[8]; ++ptr) {
-        con.send_byte(*ptr, 1);
-    }
+    if (!buffered) {
 
-    auto r = get_cursor_row();
-    auto c = get_cursor_col();
-    set_cursor_pos(r, c);
-}
+        update_display_cursor_pos();
+        write_data(&byte, 1);
+    }
 
+    store_cell(byte, !buffered);
+    advance_cursor_loc();
 
-void
-HD44780LCD::enable_backlight() {
-    con.enable_backlight();
+    unlock();
 }
 
 void
-HD44780LCD::disable_backlight() {
-    con.disable_backlight();
-}
+HD44780LCD::send_buffer(const uint8_t *buf, const uint32_t len) {
 
+    lock();
 
-void
-HD44780LCD::toggle_backlight() {
-    con.toggle_backlight();
-}
+    if (!buffered) {
 
-bool
-HD44780LCD::is_backlight_on() const {
-    return con.is_backlight_on();
-}
+        update_display_cursor_pos();
+        write_data(buf, len);
+    }
 
+    for (const uint8_t *ptr = buf; ptr != &buf[len]; ++ptr) {
 
-void
-HD44780LCD::set_cursor_auto_dec() {
+        store_cell(*ptr, !buffered);
+        advance_cursor_loc();
+    }
 
-    cursorMovement = LCD_CURSOR_POS_DEC | LCD_CURSOR_MOVE;
-    con.send_byte(LCD_SET_ENTRY_MODE | cursorMovement, 0);
+    unlock();
 }
 
-void
-HD44780LCD::set_cursor_auto_inc() {
+int
+HD44780LCD::printf_at(const uint32_t r, const uint32_t c, const char *fmt, ...) {
 
-    cursorMovement = LCD_CURSOR_POS_INC | LCD_CURSOR_MOVE;
-    con.send_byte(LCD_SET_ENTRY_MODE | cursorMovement, 0);
-}
+    std::va_list args;
 
-void
-HD44780LCD::set_display_auto_dec() {
+    va_start(args, fmt);
+    auto len = vprintf_at(r, c, fmt, args);
+    va_end(args);
 
-    cursorMovement = LCD_CURSOR_POS_INC | LCD_DISPLAY_MOVE;
-    con.send_byte(LCD_SET_ENTRY_MODE | cursorMovement, 0);
+    return len;
 }
 
-void
-HD44780LCD::set_display_auto_inc() {
+int
+HD44780LCD::vprintf_at(const uint32_t r, const uint32_t c, const char *fmt, std::va_list args) {
 
-    cursorMovement = LCD_CURSOR_POS_DEC | LCD_DISPLAY_MOVE;
-    con.send_byte(LCD_SET_ENTRY_MODE | cursorMovement, 0);
-}
+    if (!is_valid_pos(r, c)) {
+        return -1;
+    }
 
-HD44780LCD::EntryMode
-HD44780LCD::get_entry_mode() const {
+    // a run can not be longer than a line of the DDRAM, so it fits in a small buffer on the stack (with room for
+    // characters of up to 3 bytes in UTF-8)
+    char buf[(3 * DDRAM_SIZE) + 1];
 
-    switch (cursorMovement) {
+    auto len = vsnprintf(buf, sizeof(buf), fmt, args);
+    if (len < 0) {
+        return len;
+    }
 
-        case LCD_CURSOR_MOVE | LCD_CURSOR_POS_DEC:
-            return CURSOR_DEC;
+    if ((uint32_t)len >= sizeof(buf)) {
+        len = sizeof(buf) - 1;
+    }
 
-        case LCD_CURSOR_MOVE | LCD_CURSOR_POS_INC:
-            return CURSOR_INC;
+    lock();
 
-        case LCD_DISPLAY_MOVE | LCD_CURSOR_POS_INC:
-            return DISPLAY_DEC;
+    len = translate_in_place(buf, len);
 
-        case LCD_DISPLAY_MOVE | LCD_CURSOR_POS_DEC:
-            return DISPLAY_INC;
+    auto orig = geometry.rowOffsets[r];
+    uint32_t end = (c < geometry.cols)
+            ? geometry.cols
+            : (line_start(orig) + line_size() - orig);
 
-        default:
-            return CURSOR_INC;
-    }
-}
+    uint32_t count = ((uint32_t)len < (end - c)) ? len : (end - c);
 
+    set_cursor_pos(r, c);
+    send_buffer((const uint8_t *)buf, count);
 
-void
-HD44780LCD::clear_display() {
-    con.send_byte(LCD_CLEAR_DISPLAY, 0);
+    unlock();
+
+    return count;
 }
 
 void
-HD44780LCD::enable_display() {
+HD44780LCD::show_screen(const HD44780Screen &screen) {
 
-    displayState |= LCD_DISPLAY_ENABLE;
-    con.send_byte(LCD_CONTROL_DISPLAY | displayState, 0);
-}
+    constexpr uint8_t sequential = LCD_CURSOR_MOVE | LCD_CURSOR_POS_INC;
 
-void
-HD44780LCD::disable_display() {
+    const auto &layout = screen.get_geometry();
 
-    displayState &= ~LCD_DISPLAY_ENABLE;
-    con.send_byte(LCD_CONTROL_DISPLAY | displayState, 0);
-}
+    lock();
 
-void
-HD44780LCD::toggle_display() {
+    // a screen encoded for a different module can not be sent as it is, so it is written like any other text (as it is
+    // while asleep, since the outputs would switch the display on and the frame is only shown on waking up)
+    if (asleep || !i2c || !(layout == geometry) || !(screen.get_pin_map() == i2c->get_pin_map())) {
 
-    displayState ^= LCD_DISPLAY_ENABLE;
-    con.send_byte(LCD_CONTROL_DISPLAY | displayState, 0);
-}
+        uint8_t row[DDRAM_SIZE];
 
-bool
-HD44780LCD::is_display_enabled() const {
-    return displayState != 0;
-}
+        const uint32_t rows = (layout.rows < geometry.rows) ? layout.rows : geometry.rows;
+        const uint32_t cols = (layout.cols < geometry.cols) ? layout.cols : geometry.cols;
 
-void
-HD44780LCD::set_cursor_home() {
+        write_batch(BATCH_BEGIN);
+        write_entry_mode(sequential);
 
-    cursorLoc = LCD_ORIG_ADDR_FIRST;
-    con.send_byte(LCD_SET_CURSOR_HOME, 0);
-}
+        for (uint32_t r = 0; r < rows; ++r) {
 
-void
-HD44780LCD::move_cursor_left() {
+            for (uint32_t c = 0; c < cols; ++c) {
+                row[c] = screen.get_cell(r, c);
+            }
 
-    con.send_byte(LCD_SHIFT_CURSOR | LCD_CURSOR_MOVE_LT, 0);
-    dec_cursor_loc();
-}
+            set_cursor_pos(r, 0);
+            send_buffer(row, cols);
+        }
 
-void
-HD44780LCD::move_cursor_right() {
+        write_display_control(screen.get_display_state());
+        set_cursor_pos(screen.get_cursor_row(), screen.get_cursor_col());
 
-    con.send_byte(LCD_SHIFT_CURSOR | LCD_CURSOR_MOVE_RT, 0);
-    inc_cursor_loc();
-}
+        if (buffered) {
+            write_frame_changes();
+        }
 
-void
-HD44780LCD::set_cursor_pos(const uint32_t r, const uint32_t c) {
+        write_batch(BATCH_END);
 
-    if (r > 1 || c > LCD_LINE_SIZE) {
+        unlock();
         return;
     }
 
-    cursorLoc = ((r != 0)
-            ? (LCD_ORIG_ADDR_SECOND)
-            : (LCD_ORIG_ADDR_FIRST))
-            + c;
-
-    update_display_cursor_pos();
-}
+    // the queued commands are sent first, after which the outputs can be written from the calling thread
+    sync();
+    i2c->send_raw(screen.get_outputs(), screen.get_length(), screen.is_backlight_on());
 
-uint32_t
-HD44780LCD::get_cursor_row() const {
+    for (uint32_t r = 0; r < geometry.rows; ++r) {
+        for (uint32_t c = 0; c < geometry.cols; ++c) {
 
-    return (cursorLoc >= LCD_ORIG_ADDR_SECOND)
-    ? 1
-    : 0;
-}
+            auto idx = frame_index(geometry.address(r, c));
 
-uint32_t
-HD44780LCD::get_cursor_col() const {
+            frame[idx] = frameShown[idx] = screen.get_cell(r, c);
+            frameDirty[idx / 8] &= ~(1 << (idx % 8));
+        }
+    }
 
-    return cursorLoc -
-            ((cursorLoc >= LCD_ORIG_ADDR_SECOND)
-            ? LCD_ORIG_ADDR_SECOND
-            : LCD_ORIG_ADDR_FIRST);
-}
+    cursorMovement = sequential;
+    displayState = screen.get_display_state();
 
+    // the screen ends by moving the address counter to the cursor
+    cursorLoc = geometry.address(screen.get_cursor_row(), screen.get_cursor_col());
+    addrCounter = cursorLoc;
+    addrCounterValid = true;
+    addrCounterInc = true;
 
-void
-HD44780LCD::enable_cursor_display() {
+    // a failed write may have left the LCD out of step, it is recovered from the frame (which now holds the screen) like
+    // a failure of any other write
+    check_fault();
 
-    displayState |= LCD_CURSOR_ENABLE;
-    con.send_byte(LCD_CONTROL_DISPLAY | displayState, 0);
+    unlock();
 }
 
 void
-HD44780LCD::disable_cursor_display() {
-
-    displayState &= ~LCD_CURSOR_ENABLE;
-    con.send_byte(LCD_CONTROL_DISPLAY | displayState, 0);
-}
+HD44780LCD::create_custom_char(const uint32_t loc, const uint8_t *glyph) {
 
-void
-HD44780LCD::toggle_cursor_display() {
+    lock();
 
-    displayState ^= LCD_CURSOR_ENABLE;
-    con.send_byte(LCD_CONTROL_DISPLAY | displayState, 0);
-}
+    write_instruction(LCD_SET_CGRAMADDR | (loc << 3));
 
-bool
-HD44780LCD::is_cursor_displayed() const {
-    return (displayState & LCD_CURSOR_ENABLE) != 0;
-}
+    write_data(glyph, 8);
 
-void
-HD44780LCD::enable_blinking_cursor() {
+    // the address counter is left in the CGRAM, and is moved back to the DDRAM before the next character is sent
+    request_cursor_pos_update();
 
-    displayState |= LCD_BLINK_ENABLE;
-    con.send_byte(LCD_CONTROL_DISPLAY | displayState, 0);
+    unlock();
 }
 
 void
-HD44780LCD::disable_blinking_cursor() {
+HD44780LCD::load_glyphs(const uint32_t first, const uint32_t count, const uint8_t glyphs[][8]) {
 
-    displayState &= ~LCD_BLINK_ENABLE;
-    con.send_byte(LCD_CONTROL_DISPLAY | displayState, 0);
-}
+    if (first >= LCD_GLYPH_COUNT || count == 0) {
+        return;
+    }
 
-void
-HD44780LCD::toggle_blinking_cursor() {
+    auto len = (count < (LCD_GLYPH_COUNT - first)) ? count : (LCD_GLYPH_COUNT - first);
 
-    displayState ^= LCD_BLINK_ENABLE;
-    con.send_byte(LCD_CONTROL_DISPLAY | displayState, 0);
-}
+    lock();
 
-bool
-HD44780LCD::is_blinking_cursor_displayed() const {
-    return (displayState & LCD_BLINK_ENABLE) != 0;
-}
+    // the address counter moves through consecutive glyphs in the CGRAM, so all of them can be streamed at once
+    write_batch(BATCH_BEGIN);
+    write_instruction(LCD_SET_CGRAMADDR | (first << 3));
+    write_data(glyphs[0], len * sizeof(glyphs[0]));
+    write_batch(BATCH_END);
 
+    request_cursor_pos_update();
 
-void
-HD44780LCD::scroll_display_left() {
-    con.send_byte(LCD_SHIFT_CURSOR | LCD_DISPLAY_MOVE_LT, 0);
+    unlock();
 }
 
 void
-HD44780LCD::scroll_display_right() {
-    con.send_byte(LCD_SHIFT_CURSOR | LCD_DISPLAY_MOVE_RT, 0);
+HD44780LCD::load_glyph_set(const uint8_t glyphs[8][8]) {
+    load_glyphs(0, LCD_GLYPH_COUNT, glyphs);
 }
 
 
-HD44780LCD *HD44780LCD::get_stream() {
+void
+HD44780LCD::set_charset(Charset charset) {
 
-    initialize();
-    return this;
-}
+    lock();
 
+    this->charset = charset;
+    utf8Remaining = 0;
 
-int HD44780LCD::_putc(int c) {
+    unlock();
+}
 
-    auto row = get_cursor_row();
-    auto col = get_cursor_col();
+HD44780LCD::Charset
+HD44780LCD::get_charset() const {
+    return charset;
+}
 
-    switch (c) {
+bool
+HD44780LCD::map_custom_char(uint32_t codepoint, uint32_t loc) {
 
-        case '\n':
+    if (codepoint < 0x20 || loc >= LCD_GLYPH_COUNT) {
+        return false;
+    }
 
-            set_cursor_pos(row ^ 1, col);
-            return 0;
+    lock();
 
-        case '\r':
+    // a code point shows a single custom character, so any previous mapping of it is removed
+    for (auto &mapped : customCodepoints) {
+        if (mapped == codepoint) {
+            mapped = 0;
+        }
+    }
+    customCodepoints[loc] = codepoint;
 
-            set_cursor_pos(row, 0);
-            return 0;
+    unlock();
 
-        default:
+    return true;
+}
 
-            send_data((uint8_t)c);
-            break;
-    }
+void
+HD44780LCD::clear_custom_char_map() {
 
-    return 0;
+    lock();
+    memset(customCodepoints, 0, sizeof(customCodepoints));
+    unlock();
 }
 
-int HD44780LCD::_getc() {
-    return -1;
+void
+HD44780LCD::set_replacement_char(uint8_t code) {
+
+    lock();
+    replacementChar = code;
+    unlock();
 }
 
-// private methods
 
 void
-HD44780LCD::update_display_cursor_pos() {
-    con.send_byte(LCD_SET_DDRAMADDR | cursorLoc, 0);
+HD44780LCD::enable_buffering() {
+
+    lock();
+    buffered = true;
+    unlock();
 }
 
 void
-HD44780LCD::inc_cursor_loc() {
+HD44780LCD::disable_buffering() {
 
-    ++cursorLoc;
-    if (cursorLoc >= (LCD_ORIG_ADDR_SECOND + LCD_LINE_SIZE)) {
-        cursorLoc = LCD_ORIG_ADDR_FIRST;
-        //update_display_cursor_pos();
-    }
-    else if ((cursorLoc < LCD_ORIG_ADDR_SECOND)
-                && (cursorLoc >= (LCD_ORIG_ADDR_FIRST + LCD_LINE_SIZE))) {
-        cursorLoc = LCD_ORIG_ADDR_SECOND;
-        //update_display_cursor_pos();
-    }
+    lock();
+
+    flush();
+    buffered = false;
+
+    unlock();
+}
+
+bool
+HD44780LCD::is_buffering_enabled() const {
+    return buffered;
 }
 
 void
-HD44780LCD::dec_cursor_loc() {
+HD44780LCD::flush() {
 
-    if (cursorLoc == LCD_ORIG_ADDR_FIRST) {
-        cursorLoc = LCD_ORIG_ADDR_SECOND + LCD_LINE_SIZE - 1;
-        //update_display_cursor_pos();
-    }
-    else if (cursorLoc == LCD_ORIG_ADDR_SECOND) {
-        cursorLoc = LCD_ORIG_ADDR_FIRST + LCD_LINE_SIZE - 1;
-        //update_display_cursor_pos();
-    }
-    else {
-        --cursorLoc;
-    }
+    lock();
+
+    write_batch(BATCH_BEGIN);
+    write_frame_changes();
+    write_batch(BATCH_END);
+
+    unlock();
 }
 
-// private class methods
+#if DEVICE_I2C_ASYNCH
+void
+HD44780LCD::flush_async(Callback<void(int)> done) {
 
-HD44780LCD::I2CInterface::I2CInterface(PinName I2cSda, PinName I2cScl, uint8_t addr)
-        : con(I2cSda, I2cScl)
-        , addr {addr}
-        , backlightMask {0}
-{}
+    lock();
 
+    // the callback is picked up when the end of the batch is sent, which may be done later by the consumer
+    sync();
+    flushDone = done;
 
-void
-HD44780LCD::I2CInterface::send_byte(uint8_t byte, uint8_t isData) {
+    write_batch(BATCH_BEGIN);
+    write_frame_changes();
+    write_batch(BATCH_END_ASYNC);
 
-    static struct {
+    unlock();
+}
+#endif // DEVICE_I2C_ASYNCH
 
-        uint8_t result;
-        uint8_t buf[3];
-    } pack;
-    static_assert(sizeof(pack) == 4);
 
-    for (uint32_t _ = 0; _ <= 4; _ += 4) {
+void
+HD44780LCD::enable_async(EventQueue *queue) {
 
-        auto nibble = (byte >> (4 ^ _)) & 0xf;
-        pack.result = (nibble << 4) | (isData << RS_ID) | backlightMask;
+    lock();
 
-        pack.buf[0] = pack.result;
-        pack.buf[1] = pack.result | (1 << EN_ID);
-        pack.buf[2] = pack.result;
+    if (!asyncEnabled) {
 
-        for (const uint8_t *ptr = pack.buf; ptr != &pack.buf[3]; ++ptr) {
+        asyncEvents = queue;
+        asyncEnabled = true;
 
-            con.write(addr, (const char *)ptr, 1);
-            ThisThread::sleep_for(1ms);
+        if (asyncEvents == nullptr) {
+
+            asyncThread = new Thread(osPriorityNormal, HD44780LCD_ASYNC_STACK_SIZE);
+            asyncThread->start(callback(this, &HD44780LCD::async_thread_main));
         }
     }
+
+    unlock();
 }
 
 void
-HD44780LCD::I2CInterface::send_nibble(uint8_t nibble, uint8_t isData) {
+HD44780LCD::disable_async() {
 
-    static struct {
+    lock();
 
-        uint8_t result;
-        uint8_t buf[3];
-    } pack;
-    static_assert(sizeof(pack) == 4);
+    if (asyncEnabled) {
 
-    pack.result = (nibble << 4) | (isData << RS_ID) | backlightMask;
+        sync();
+        asyncEnabled = false;
 
-    pack.buf[0] = pack.result;
-    pack.buf[1] = pack.result | (1 << EN_ID);
-    pack.buf[2] = pack.result;
+        if (asyncThread != nullptr) {
 
-    for (const uint8_t *ptr = pack.buf; ptr != &pack.buf[3]; ++ptr) {
+            // the thread exits once it is woken with asynchronous mode disabled
+            asyncThread->flags_set(ASYNC_DRAIN_FLAG);
+            asyncThread->join();
 
-        con.write(addr, (const char *)ptr, 1);
-        ThisThread::sleep_for(1ms);
+            delete asyncThread;
+            asyncThread = nullptr;
+        }
+
+        asyncEvents = nullptr;
     }
-}
 
-void
-HD44780LCD::I2CInterface::enable_backlight() {
+    unlock();
+}
 
-    backlightMask = (1 << BACKLIGHT_ID);
-    con.write(addr, (const char *)(&backlightMask), 1);
+bool
+HD44780LCD::is_async_enabled() const {
+    return asyncEnabled;
 }
 
 void
-HD44780LCD::I2CInterface::disable_backlight() {
+HD44780LCD::sync() {
+
+    lock();
 
-    backlightMask &= ~(1 << BACKLIGHT_ID);
-    con.write(addr, (const char *)(&backlightMask), 1);
+    while (asyncEnabled
+            && (core_util_atomic_load_u32(&asyncHead) != core_util_atomic_load_u32(&asyncTail)
+                || core_util_atomic_load_bool(&asyncNotified)
+                || core_util_atomic_load_bool(&asyncBusy))) {
+
+        ThisThread::sleep_for(1ms);
+    }
+
+    con.wait_transfer();
+
+    unlock();
 }
 
+
 void
-HD44780LCD::I2CInterface::toggle_backlight() {
+HD44780LCD::enable_backlight() {
 
-    backlightMask ^= (1 << BACKLIGHT_ID);
-    con.write(addr, (const char *)(&backlightMask), 1);
+    lock();
+    write_backlight(true);
+    unlock();
+}
+
+void
+HD44780LCD::disable_backlight() {
+
+    lock();
+    write_backlight(false);
+    unlock();
+}
+
+
+void
+HD44780LCD::toggle_backlight() {
+
+    lock();
+    write_backlight(!backlightOn);
+    unlock();
+}
+
+bool
+HD44780LCD::is_backlight_on() const {
+    return backlightOn;
+}
+
+bool
+HD44780LCD::enable_dimming(EventQueue &queue, std::chrono::milliseconds period) {
+
+    lock();
+
+    bool enabled = false;
+
+    if (dimmingQueue == nullptr) {
+
+        dimmingPeriod = period;
+
+        // while asleep, the steps are only scheduled on waking up
+        if (!asleep) {
+            dimmingEvent = queue.call_every(period, callback(this, &HD44780LCD::dimming_step));
+        }
+
+        enabled = asleep || dimmingEvent != 0;
+        if (enabled) {
+            dimmingQueue = &queue;
+        }
+    }
+
+    unlock();
+
+    return enabled;
+}
+
+void
+HD44780LCD::disable_dimming() {
+
+    lock();
+
+    if (dimmingQueue != nullptr) {
+
+        // a step that is already running skips itself, since the mutex is held here
+        if (dimmingEvent != 0) {
+            dimmingQueue->cancel(dimmingEvent);
+        }
+
+        dimmingQueue = nullptr;
+        dimmingEvent = 0;
+
+        if (is_backlight_lit() != backlightLit) {
+            send_backlight(is_backlight_lit());
+        }
+    }
+
+    unlock();
+}
+
+void
+HD44780LCD::set_backlight_level(uint32_t level) {
+
+    lock();
+    backlightLevel = (level < HD44780LCD_DIMMING_LEVELS) ? level : HD44780LCD_DIMMING_LEVELS;
+    unlock();
+}
+
+uint32_t
+HD44780LCD::get_backlight_level() const {
+    return backlightLevel;
+}
+
+
+void
+HD44780LCD::sleep() {
+
+    lock();
+
+    if (asleep) {
+
+        unlock();
+        return;
+    }
+
+    // the characters written so far are shown, those written while asleep are collected in the frame
+    if (buffered) {
+        flush();
+    }
+
+    bufferedBeforeSleep = buffered;
+    buffered = true;
+
+    wakeDisplayState = displayState;
+    write_display_control(displayState & ~LCD_DISPLAY_ENABLE);
+
+    asleep = true;
+
+    if (dimmingEvent != 0) {
+
+        dimmingQueue->cancel(dimmingEvent);
+        dimmingEvent = 0;
+    }
+
+    send_backlight(false);
+
+    sync();
+    con.suspend();
+
+    unlock();
+}
+
+void
+HD44780LCD::wake() {
+
+    lock();
+
+    if (!asleep) {
+
+        unlock();
+        return;
+    }
+
+    con.resume();
+    asleep = false;
+
+    buffered = bufferedBeforeSleep;
+    if (!buffered) {
+        flush();
+    }
+
+    write_display_control(wakeDisplayState);
+    send_backlight(is_backlight_lit());
+
+    if (dimmingQueue != nullptr) {
+        dimmingEvent = dimmingQueue->call_every(dimmingPeriod, callback(this, &HD44780LCD::dimming_step));
+    }
+
+    unlock();
+}
+
+bool
+HD44780LCD::is_asleep() const {
+    return asleep;
+}
+
+#if HD44780LCD_ENABLE_STATS
+HD44780LCD::Stats
+HD44780LCD::get_stats() {
+
+    lock();
+    Stats stats = con.get_stats();
+    unlock();
+
+    return stats;
+}
+
+void
+HD44780LCD::reset_stats() {
+
+    lock();
+    con.reset_stats();
+    unlock();
+}
+#endif // HD44780LCD_ENABLE_STATS
+
+
+void
+HD44780LCD::enable_busy_polling() {
+
+    lock();
+    con.set_busy_polling(true);
+    unlock();
+}
+
+void
+HD44780LCD::disable_busy_polling() {
+
+    lock();
+    con.set_busy_polling(false);
+    unlock();
+}
+
+bool
+HD44780LCD::is_busy_polling_enabled() const {
+    return con.is_busy_polling();
+}
+
+uint32_t
+HD44780LCD::read_address_counter() {
+
+    lock();
+
+    sync();
+    const uint32_t loc = con.read_status() & LCD_ADDR_COUNTER;
+
+    // a failed read leaves the LCD out of step with the transport, like a failed write
+    check_fault();
+
+    unlock();
+
+    return loc;
+}
+
+bool
+HD44780LCD::is_cursor_pos_synced() {
+
+    lock();
+
+    if (!buffered) {
+        update_display_cursor_pos();
+    }
+
+    // a mismatch means that the tracked address counter can not be trusted either
+    auto synced = (read_address_counter() == cursorLoc);
+    if (!synced) {
+        addrCounterValid = false;
+    }
+
+    unlock();
+
+    return synced;
+}
+
+
+void
+HD44780LCD::set_cursor_auto_dec() {
+
+    lock();
+    write_entry_mode(LCD_CURSOR_POS_DEC | LCD_CURSOR_MOVE);
+    unlock();
+}
+
+void
+HD44780LCD::set_cursor_auto_inc() {
+
+    lock();
+    write_entry_mode(LCD_CURSOR_POS_INC | LCD_CURSOR_MOVE);
+    unlock();
+}
+
+void
+HD44780LCD::set_display_auto_dec() {
+
+    lock();
+    write_entry_mode(LCD_CURSOR_POS_INC | LCD_DISPLAY_MOVE);
+    unlock();
+}
+
+void
+HD44780LCD::set_display_auto_inc() {
+
+    lock();
+    write_entry_mode(LCD_CURSOR_POS_DEC | LCD_DISPLAY_MOVE);
+    unlock();
+}
+
+HD44780LCD::EntryMode
+HD44780LCD::get_entry_mode() const {
+
+    switch (cursorMovement) {
+
+        case LCD_CURSOR_MOVE | LCD_CURSOR_POS_DEC:
+            return CURSOR_DEC;
+
+        case LCD_CURSOR_MOVE | LCD_CURSOR_POS_INC:
+            return CURSOR_INC;
+
+        case LCD_DISPLAY_MOVE | LCD_CURSOR_POS_INC:
+            return DISPLAY_DEC;
+
+        case LCD_DISPLAY_MOVE | LCD_CURSOR_POS_DEC:
+            return DISPLAY_INC;
+
+        default:
+            return CURSOR_INC;
+    }
+}
+
+
+void
+HD44780LCD::clear_display() {
+
+    lock();
+
+    // clearing the display also returns the cursor home
+    cursorLoc = LCD_ORIG_ADDR_FIRST;
+
+    if (buffered) {
+        clear_frame(false);
+    }
+    else {
+
+        write_instruction(LCD_CLEAR_DISPLAY, LONG_EXEC_TIME);
+        clear_frame(true);
+
+        // clearing the display also sets the entry mode to increment, which would otherwise differ from the cached one
+        if ((cursorMovement & LCD_CURSOR_POS_INC) == 0) {
+            write_instruction(LCD_SET_ENTRY_MODE | cursorMovement);
+        }
+    }
+
+    unlock();
+}
+
+void
+HD44780LCD::enable_display() {
+
+    lock();
+    write_display_control(displayState | LCD_DISPLAY_ENABLE);
+    unlock();
+}
+
+void
+HD44780LCD::disable_display() {
+
+    lock();
+    write_display_control(displayState & ~LCD_DISPLAY_ENABLE);
+    unlock();
+}
+
+void
+HD44780LCD::toggle_display() {
+
+    lock();
+    write_display_control(displayState ^ LCD_DISPLAY_ENABLE);
+    unlock();
+}
+
+void
+HD44780LCD::set_display_control(bool display, bool cursor, bool blink) {
+
+    lock();
+
+    write_display_control((display ? LCD_DISPLAY_ENABLE : 0)
+            | (cursor ? LCD_CURSOR_ENABLE : LCD_CURSOR_DISABLE)
+            | (blink ? LCD_BLINK_ENABLE : LCD_BLINK_DISABLE));
+
+    unlock();
+}
+
+bool
+HD44780LCD::is_display_enabled() const {
+    return (displayState & LCD_DISPLAY_ENABLE) != 0;
+}
+
+void
+HD44780LCD::set_cursor_home() {
+
+    lock();
+
+    cursorLoc = LCD_ORIG_ADDR_FIRST;
+    write_instruction(LCD_SET_CURSOR_HOME, LONG_EXEC_TIME);
+
+    unlock();
+}
+
+void
+HD44780LCD::move_cursor_left() {
+
+    lock();
+
+    dec_cursor_loc();
+
+    if (!buffered) {
+        request_cursor_pos_update();
+    }
+
+    unlock();
+}
+
+void
+HD44780LCD::move_cursor_right() {
+
+    lock();
+
+    inc_cursor_loc();
+
+    if (!buffered) {
+        request_cursor_pos_update();
+    }
+
+    unlock();
+}
+
+void
+HD44780LCD::set_cursor_pos(const uint32_t r, const uint32_t c) {
+
+    if (!is_valid_pos(r, c)) {
+        return;
+    }
+
+    lock();
+
+    cursorLoc = geometry.address(r, c);
+
+    if (!buffered) {
+        request_cursor_pos_update();
+    }
+
+    unlock();
+}
+
+uint32_t
+HD44780LCD::get_cursor_row() const {
+
+    // the cursor lies in the row of the same line that starts closest before it
+    auto start = line_start(cursorLoc);
+    uint32_t row = 0;
+
+    for (uint32_t r = 0; r < geometry.rows; ++r) {
+
+        auto orig = geometry.rowOffsets[r];
+        if (orig >= start && orig <= cursorLoc && orig >= geometry.rowOffsets[row]) {
+            row = r;
+        }
+    }
+
+    return row;
+}
+
+uint32_t
+HD44780LCD::get_cursor_col() const {
+
+    return cursorLoc - geometry.rowOffsets[get_cursor_row()];
+}
+
+uint8_t
+HD44780LCD::get_char_at(const uint32_t r, const uint32_t c) const {
+
+    if (!is_valid_pos(r, c)) {
+        return ' ';
+    }
+
+    return frame[frame_index(geometry.address(r, c))];
+}
+
+uint32_t
+HD44780LCD::get_row_count() const {
+
+    return geometry.rows;
+}
+
+uint32_t
+HD44780LCD::get_col_count() const {
+
+    return geometry.cols;
+}
+
+uint32_t
+HD44780LCD::get_line_size() const {
+    return line_size();
+}
+
+const HD44780LCD::Geometry &
+HD44780LCD::get_geometry() const {
+    return geometry;
+}
+
+
+void
+HD44780LCD::enable_cursor_display() {
+
+    lock();
+    write_display_control(displayState | LCD_CURSOR_ENABLE);
+    unlock();
+}
+
+void
+HD44780LCD::disable_cursor_display() {
+
+    lock();
+    write_display_control(displayState & ~LCD_CURSOR_ENABLE);
+    unlock();
+}
+
+void
+HD44780LCD::toggle_cursor_display() {
+
+    lock();
+    write_display_control(displayState ^ LCD_CURSOR_ENABLE);
+    unlock();
+}
+
+bool
+HD44780LCD::is_cursor_displayed() const {
+    return (displayState & LCD_CURSOR_ENABLE) != 0;
+}
+
+void
+HD44780LCD::enable_blinking_cursor() {
+
+    lock();
+    write_display_control(displayState | LCD_BLINK_ENABLE);
+    unlock();
+}
+
+void
+HD44780LCD::disable_blinking_cursor() {
+
+    lock();
+    write_display_control(displayState & ~LCD_BLINK_ENABLE);
+    unlock();
+}
+
+void
+HD44780LCD::toggle_blinking_cursor() {
+
+    lock();
+    write_display_control(displayState ^ LCD_BLINK_ENABLE);
+    unlock();
+}
+
+bool
+HD44780LCD::is_blinking_cursor_displayed() const {
+    return (displayState & LCD_BLINK_ENABLE) != 0;
+}
+
+
+void
+HD44780LCD::scroll_display_left() {
+
+    lock();
+    write_instruction(LCD_SHIFT_CURSOR | LCD_DISPLAY_MOVE_LT);
+    unlock();
+}
+
+void
+HD44780LCD::scroll_display_right() {
+
+    lock();
+    write_instruction(LCD_SHIFT_CURSOR | LCD_DISPLAY_MOVE_RT);
+    unlock();
+}
+
+
+HD44780LCD *HD44780LCD::get_stream() {
+
+    if (!initialized) {
+        initialize();
+    }
+    return this;
+}
+
+
+int HD44780LCD::_putc(int c) {
+
+    lock();
+
+    switch (c) {
+
+        case '\n':
+
+            new_line();
+            break;
+
+        case '\r':
+
+            carriage_return();
+            break;
+
+        default:
+
+            if (charset == Charset::RAW) {
+
+                send_data((uint8_t)c);
+                break;
+            }
+
+            uint32_t codepoint;
+            if (decode_utf8((uint8_t)c, codepoint)) {
+                send_data(translate(codepoint));
+            }
+            break;
+    }
+
+    unlock();
+
+    return 0;
+}
+
+int HD44780LCD::_getc() {
+    return -1;
+}
+
+ssize_t HD44780LCD::write(const void *buffer, size_t length) {
+
+    auto buf = (const uint8_t *)buffer;
+    uint32_t start = 0;
+
+    lock();
+
+    // the whole block is collected into a batch, so that runs and cursor movements share transactions
+    if (!buffered) {
+        write_batch(BATCH_BEGIN);
+    }
+
+    if (charset != Charset::RAW) {
+        write_translated(buf, length);
+    }
+    else {
+
+        for (uint32_t idx = 0; idx < length; ++idx) {
+
+            if (buf[idx] != '\n' && buf[idx] != '\r') {
+                continue;
+            }
+
+            if (idx != start) {
+                send_buffer(&buf[start], idx - start);
+            }
+
+            (buf[idx] == '\n')
+            ? new_line()
+            : carriage_return();
+
+            start = idx + 1;
+        }
+
+        if (length != start) {
+            send_buffer(&buf[start], length - start);
+        }
+    }
+
+    if (!buffered) {
+        write_batch(BATCH_END);
+    }
+
+    unlock();
+
+    return length;
+}
+
+void
+HD44780LCD::lock() {
+
+    // the mutex can not be taken in ISR context
+    if (!core_util_is_isr_active()) {
+        mutex.lock();
+    }
+}
+
+void
+HD44780LCD::unlock() {
+
+    if (!core_util_is_isr_active()) {
+        mutex.unlock();
+    }
+}
+
+// private methods
+
+void
+HD44780LCD::begin_session() {
+
+    lock();
+    write_batch(BATCH_BEGIN);
+}
+
+bool
+HD44780LCD::prepare_session() {
+
+    if (buffered) {
+        write_frame_changes();
+    }
+
+    return batchDepth == 1 && !batchAsync && !asyncEnabled && con.has_pending();
+}
+
+void
+HD44780LCD::end_session(bool repeated) {
+
+    // batches that are written in the shared session bypass the queue, so they are ended on the interface directly
+    if (batchDepth == 1 && !batchAsync && !asyncEnabled) {
+
+        batchDepth = 0;
+        con.end_batch(repeated);
+
+        check_fault();
+    }
+    else {
+        write_batch(BATCH_END);
+    }
+
+    unlock();
+}
+
+void
+HD44780LCD::new_line() {
+
+    set_cursor_pos((get_cursor_row() + 1) % geometry.rows, get_cursor_col());
+}
+
+void
+HD44780LCD::carriage_return() {
+
+    set_cursor_pos(get_cursor_row(), 0);
+}
+
+void
+HD44780LCD::update_display_cursor_pos() {
+    set_address_counter(cursorLoc);
+}
+
+void
+HD44780LCD::request_cursor_pos_update() {
+
+    // a hidden cursor only needs to be in place before the next character is sent
+    if ((displayState & LCD_DISPLAY_ENABLE) && (displayState & (LCD_CURSOR_ENABLE | LCD_BLINK_ENABLE))) {
+        update_display_cursor_pos();
+    }
+}
+
+void
+HD44780LCD::set_address_counter(uint32_t loc) {
+
+    if (addrCounterValid && addrCounter == loc) {
+        return;
+    }
+
+    write_instruction(LCD_SET_DDRAMADDR | loc);
+}
+
+void
+HD44780LCD::write_display_control(uint16_t state) {
+
+    // the display stays off while asleep, the state is applied on waking up
+    if (asleep) {
+
+        wakeDisplayState = state;
+        return;
+    }
+
+    // the LCD already holds the cached state, so sending it again would not change anything
+    if (state == displayState) {
+        return;
+    }
+
+    displayState = state;
+    write_instruction(LCD_CONTROL_DISPLAY | displayState);
+
+    if (!buffered) {
+        request_cursor_pos_update();
+    }
+}
+
+void
+HD44780LCD::write_entry_mode(uint16_t movement) {
+
+    if (movement == cursorMovement) {
+        return;
+    }
+
+    cursorMovement = movement;
+    write_instruction(LCD_SET_ENTRY_MODE | cursorMovement);
+}
+
+void
+HD44780LCD::write_frame_changes() {
+
+    constexpr uint8_t sequential = LCD_CURSOR_MOVE | LCD_CURSOR_POS_INC;
+
+    bool entryModeChanged = false;
+
+    // a cell needs to be sent if it has been written to and its contents differ from those on the LCD
+    auto changed = [this](uint32_t idx) {
+
+        return ((frameDirty[idx / 8] & (1 << (idx % 8))) != 0)
+                && (frame[idx] != frameShown[idx]);
+    };
+
+    for (uint32_t idx = 0; idx < DDRAM_SIZE; ) {
+
+        if (!changed(idx)) {
+            ++idx;
+            continue;
+        }
+
+        // runs are sent in increasing order of address, without scrolling the display
+        if (!entryModeChanged && cursorMovement != sequential) {
+
+            write_instruction(LCD_SET_ENTRY_MODE | sequential);
+            entryModeChanged = true;
+        }
+
+        uint32_t len = 0;
+        while ((idx + len) < DDRAM_SIZE && changed(idx + len)) {
+
+            frameShown[idx + len] = frame[idx + len];
+            ++len;
+        }
+
+        set_address_counter(frame_loc(idx));
+        write_data(&frame[idx], len);
+
+        idx += len;
+    }
+
+    memset(frameDirty, 0, sizeof(frameDirty));
+
+    if (entryModeChanged) {
+        write_instruction(LCD_SET_ENTRY_MODE | cursorMovement);
+    }
+
+    request_cursor_pos_update();
+}
+
+
+bool
+HD44780LCD::decode_utf8(uint8_t byte, uint32_t &codepoint) {
+
+    // continuation bytes (10xxxxxx) extend the sequence being decoded
+    if ((byte & 0xc0) == 0x80) {
+
+        if (utf8Remaining == 0) {
+
+            codepoint = UTF8_INVALID;
+            return true;
+        }
+
+        utf8Codepoint = (utf8Codepoint << 6) | (byte & 0x3f);
+        if (--utf8Remaining != 0) {
+            return false;
+        }
+
+        codepoint = utf8Codepoint;
+        return true;
+    }
+
+    // any other byte starts a new sequence, dropping an incomplete one
+    utf8Remaining = 0;
+
+    if (byte < 0x80) {
+
+        codepoint = byte;
+        return true;
+    }
+
+    if ((byte & 0xe0) == 0xc0) {
+
+        utf8Codepoint = byte & 0x1f;
+        utf8Remaining = 1;
+    }
+    else if ((byte & 0xf0) == 0xe0) {
+
+        utf8Codepoint = byte & 0x0f;
+        utf8Remaining = 2;
+    }
+    else if ((byte & 0xf8) == 0xf0) {
+
+        utf8Codepoint = byte & 0x07;
+        utf8Remaining = 3;
+    }
+    else {
+
+        codepoint = UTF8_INVALID;
+        return true;
+    }
+
+    return false;
+}
+
+uint8_t
+HD44780LCD::translate(uint32_t codepoint) const {
+
+    // control characters address the custom characters (and their mirrors) directly
+    if (codepoint < 0x20) {
+        return codepoint;
+    }
+
+    for (uint32_t loc = 0; loc < LCD_GLYPH_COUNT; ++loc) {
+        if (customCodepoints[loc] == codepoint) {
+            return loc;
+        }
+    }
+
+    int32_t code = (charset == Charset::UTF8_A00)
+            ? rom_lookup(ROM_A00, sizeof(ROM_A00) / sizeof(ROM_A00[0]), codepoint)
+            : rom_lookup(ROM_A02, sizeof(ROM_A02) / sizeof(ROM_A02[0]), codepoint);
+
+    return (code >= 0) ? code : replacementChar;
+}
+
+uint32_t
+HD44780LCD::translate_in_place(char *buf, uint32_t len) {
+
+    if (charset == Charset::RAW) {
+        return len;
+    }
+
+    // the characters are never longer than their encoding, so they are translated in place
+    uint32_t count = 0;
+    uint32_t codepoint;
+
+    utf8Remaining = 0;
+    for (uint32_t idx = 0; idx < len; ++idx) {
+        if (decode_utf8(buf[idx], codepoint)) {
+            buf[count++] = translate(codepoint);
+        }
+    }
+    utf8Remaining = 0;
+
+    return count;
+}
+
+void
+HD44780LCD::write_translated(const uint8_t *buf, size_t length) {
+
+    uint8_t chunk[TRANSLATE_CHUNK];
+    uint32_t len = 0;
+
+    for (const uint8_t *ptr = buf; ptr != &buf[length]; ++ptr) {
+
+        uint32_t codepoint;
+        if (!decode_utf8(*ptr, codepoint)) {
+            continue;
+        }
+
+        if (codepoint != '\n' && codepoint != '\r') {
+
+            chunk[len++] = translate(codepoint);
+            if (len == TRANSLATE_CHUNK) {
+
+                send_buffer(chunk, len);
+                len = 0;
+            }
+            continue;
+        }
+
+        if (len != 0) {
+
+            send_buffer(chunk, len);
+            len = 0;
+        }
+
+        (codepoint == '\n')
+        ? new_line()
+        : carriage_return();
+    }
+
+    if (len != 0) {
+        send_buffer(chunk, len);
+    }
+}
+
+void
+HD44780LCD::send_resync_sequence() {
+
+    // the busy flag can not be read until the LCD is in 4-bit mode, so the datasheet delays are waited out
+    auto polling = con.is_busy_polling();
+    const bool wide = (con.get_bus_width() == 8);
+    con.set_busy_polling(false);
+
+    con.send_nibble(HI_NIBBLE(LCD_SET_FUNCTION | LCD_BUS_SIZE_8), 0, RESYNC_TIME_FIRST);
+    con.send_nibble(HI_NIBBLE(LCD_SET_FUNCTION | LCD_BUS_SIZE_8), 0, RESYNC_TIME);
+    con.send_nibble(HI_NIBBLE(LCD_SET_FUNCTION | LCD_BUS_SIZE_8), 0, RESYNC_TIME);
+
+    // transports driving all 8 data pins keep the LCD in full-bus mode
+    if (!wide) {
+        con.send_nibble(HI_NIBBLE(LCD_SET_FUNCTION | LCD_BUS_SIZE_4), 0);
+    }
+
+    con.set_busy_polling(polling);
+}
+
+void
+HD44780LCD::recover() {
+
+    constexpr uint8_t sequential = LCD_CURSOR_MOVE | LCD_CURSOR_POS_INC;
+
+    recovering = true;
+
+    con.reset_bus();
+
+    // the function sets bring the LCD into 8-bit mode whichever half of a byte it was expecting, so that the switch
+    // into 4-bit mode leaves both sides in step again
+    send_resync_sequence();
+
+    con.send_byte(LCD_SET_FUNCTION | ((con.get_bus_width() == 8) ? LCD_BUS_SIZE_8 : LCD_BUS_SIZE_4) | LCD_DOT_COUNT_8
+            | (geometry.is_two_line() ? LCD_LINE_COUNT_2 : LCD_LINE_COUNT_1), 0);
+
+    // the DDRAM may hold characters written while out of sync, so it is cleared and only the non-blank cells are sent
+    con.send_byte(LCD_CLEAR_DISPLAY, 0, LONG_EXEC_TIME);
+    con.send_byte(LCD_SET_ENTRY_MODE | sequential, 0);
+
+    con.begin_batch();
+
+    for (uint32_t idx = 0; idx < DDRAM_SIZE; ) {
+
+        if (frameShown[idx] == ' ') {
+            ++idx;
+            continue;
+        }
+
+        uint32_t len = 0;
+        while ((idx + len) < DDRAM_SIZE && frameShown[idx + len] != ' ') {
+            ++len;
+        }
+
+        con.send_byte(LCD_SET_DDRAMADDR | frame_loc(idx), 0);
+        con.send_buffer(&frameShown[idx], len, 1);
+
+        idx += len;
+    }
+
+    con.send_byte(LCD_SET_ENTRY_MODE | cursorMovement, 0);
+    con.send_byte(LCD_CONTROL_DISPLAY | displayState, 0);
+
+    // the address counter is left after the last cell sent, so the cursor is moved back explicitly, through the
+    // transport rather than the queue (in asynchronous mode this runs on the consumer, which must not produce commands)
+    addrCounterValid = false;
+    if (initialized) {
+
+        con.send_byte(LCD_SET_DDRAMADDR | cursorLoc, 0);
+        addrCounter = cursorLoc;
+        addrCounterValid = true;
+    }
+
+    con.end_batch();
+
+    recovering = false;
+}
+
+void
+HD44780LCD::check_fault() {
+
+    if (recovering || asyncEnabled || batchDepth != 0 || !con.take_fault()) {
+        return;
+    }
+
+    // a fault during the recovery stays latched and is recovered after the next command, instead of looping here
+    // while the chip does not respond
+    recover();
+}
+
+void
+HD44780LCD::write_instruction(uint8_t instr, std::chrono::microseconds execTime) {
+
+    track_instruction(instr);
+
+    if (!asyncEnabled) {
+
+        con.send_byte(instr, 0, execTime);
+        check_fault();
+        return;
+    }
+
+    push_async(((execTime > EXEC_TIME) ? ASYNC_LONG_INSTR : ASYNC_INSTRUCTION) | instr);
+    notify_async();
+}
+
+void
+HD44780LCD::write_data(const uint8_t *buf, uint32_t len) {
+
+    track_data(len);
+
+    if (!asyncEnabled) {
+
+        con.send_buffer(buf, len, 1);
+        check_fault();
+        return;
+    }
+
+    for (const uint8_t *ptr = buf; ptr != &buf[len]; ++ptr) {
+        push_async(ASYNC_DATA | *ptr);
+    }
+    notify_async();
+}
+
+void
+HD44780LCD::write_backlight(bool on) {
+
+    backlightOn = on;
+
+    // the backlight is left off while asleep, and is switched on by the next dimming step when dimmed
+    if (asleep) {
+        return;
+    }
+
+    send_backlight(is_backlight_lit());
+}
+
+bool
+HD44780LCD::is_backlight_lit() const {
+
+    if (!backlightOn || asleep) {
+        return false;
+    }
+
+    return (dimmingQueue == nullptr) || (dimmingPhase < backlightLevel);
+}
+
+void
+HD44780LCD::send_backlight(bool lit) {
+
+    backlightLit = lit;
+
+    if (!asyncEnabled) {
+
+        lit ? con.enable_backlight() : con.disable_backlight();
+        return;
+    }
+
+    push_async(ASYNC_BACKLIGHT | (lit ? 1 : 0));
+    notify_async();
+}
+
+void
+HD44780LCD::dimming_step() {
+
+    // a step that would have to wait for another thread is skipped, so that the queue is never blocked
+    if (!mutex.trylock()) {
+        return;
+    }
+
+    dimmingPhase = (dimmingPhase + 1) % HD44780LCD_DIMMING_LEVELS;
+
+    if (is_backlight_lit() != backlightLit) {
+        send_backlight(!backlightLit);
+    }
+
+    mutex.unlock();
+}
+
+void
+HD44780LCD::write_batch(uint8_t marker) {
+
+    // nested batches (such as the ones within a transaction) are merged into the outermost one
+    if (marker == BATCH_BEGIN) {
+
+        if (batchDepth++ != 0) {
+            return;
+        }
+    }
+    else {
+
+        batchAsync |= (marker == BATCH_END_ASYNC);
+
+        if (--batchDepth != 0) {
+            return;
+        }
+
+        marker = batchAsync ? BATCH_END_ASYNC : BATCH_END;
+        batchAsync = false;
+    }
+
+    if (!asyncEnabled) {
+
+        switch (marker) {
+
+            case BATCH_BEGIN:
+
+                con.begin_batch();
+                break;
+
+#if DEVICE_I2C_ASYNCH
+            case BATCH_END_ASYNC:
+
+                con.end_batch_async(flushDone);
+                break;
+#endif // DEVICE_I2C_ASYNCH
+
+            default:
+
+                con.end_batch();
+                check_fault();
+                break;
+        }
+        return;
+    }
+
+    push_async(ASYNC_BATCH | marker);
+    notify_async();
+}
+
+void
+HD44780LCD::track_instruction(uint8_t instr) {
+
+    // instructions are identified by their highest set bit
+    if (instr & LCD_SET_DDRAMADDR) {
+
+        addrCounter = instr & LCD_ADDR_COUNTER;
+        addrCounterValid = true;
+    }
+    else if (instr & LCD_SET_CGRAMADDR) {
+        addrCounterValid = false;
+    }
+    else if (instr & LCD_SET_FUNCTION) {
+        // does not affect the address counter
+    }
+    else if (instr & LCD_SHIFT_CURSOR) {
+
+        // shifting the display leaves the address counter in place
+        if ((instr & LCD_DISPLAY_MOVE_LT) == 0) {
+
+            addrCounter = (instr & LCD_CURSOR_MOVE_RT)
+            ? next_loc(addrCounter)
+            : prev_loc(addrCounter);
+        }
+    }
+    else if (instr & LCD_CONTROL_DISPLAY) {
+        // does not affect the address counter
+    }
+    else if (instr & LCD_SET_ENTRY_MODE) {
+        addrCounterInc = (instr & LCD_CURSOR_POS_INC) != 0;
+    }
+    else if (instr & LCD_SET_CURSOR_HOME) {
+
+        addrCounter = LCD_ORIG_ADDR_FIRST;
+        addrCounterValid = true;
+    }
+    else if (instr & LCD_CLEAR_DISPLAY) {
+
+        // clearing the display also sets the entry mode to increment the address counter
+        addrCounter = LCD_ORIG_ADDR_FIRST;
+        addrCounterValid = true;
+        addrCounterInc = true;
+    }
+}
+
+void
+HD44780LCD::track_data(uint32_t len) {
+
+    // writes to the CGRAM move its address counter, which is not tracked
+    if (!addrCounterValid) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < len; ++i) {
+
+        addrCounter = addrCounterInc
+        ? next_loc(addrCounter)
+        : prev_loc(addrCounter);
+    }
+}
+
+void
+HD44780LCD::push_async(uint16_t command) {
+
+    auto head = core_util_atomic_load_u32(&asyncHead);
+
+    while ((head - core_util_atomic_load_u32(&asyncTail)) == ASYNC_QUEUE_SIZE) {
+
+        if (core_util_is_isr_active()) {
+
+            // the dropped command may have moved the address counter
+            addrCounterValid = false;
+            return;
+        }
+        ThisThread::sleep_for(1ms);
+    }
+
+    asyncQueue[head % ASYNC_QUEUE_SIZE] = command;
+
+    // publishing the new head after storing the command makes it visible to the consumer
+    core_util_atomic_store_u32(&asyncHead, head + 1);
+}
+
+void
+HD44780LCD::notify_async() {
+
+    // only the first notification after the consumer starts draining needs to wake it up
+    if (core_util_atomic_exchange_bool(&asyncNotified, true)) {
+        return;
+    }
+
+    if (asyncEvents != nullptr) {
+        asyncEvents->call(callback(this, &HD44780LCD::drain_async));
+    }
+    else {
+        asyncThread->flags_set(ASYNC_DRAIN_FLAG);
+    }
+}
+
+void
+HD44780LCD::drain_async() {
+
+    core_util_atomic_store_bool(&asyncBusy, true);
+    core_util_atomic_store_bool(&asyncNotified, false);
+
+    send_queued();
+
+    // the consumer owns the transport, so a transfer that failed while draining is recovered here, unless another
+    // thread holds the LCD (the fault then stays latched until the next drain)
+    if (con.has_fault() && mutex.trylock()) {
+
+        // nothing can be queued while the LCD is held, so the commands queued since are sent before recovering
+        send_queued();
+
+        con.take_fault();
+        recover();
+
+        mutex.unlock();
+    }
+
+    core_util_atomic_store_bool(&asyncBusy, false);
+}
+
+void
+HD44780LCD::send_queued() {
+
+    // consecutive data bytes are collected and sent in a single transaction
+    uint8_t data[I2CInterface::MAX_BATCH_SIZE];
+    uint32_t len = 0;
+
+    auto tail = core_util_atomic_load_u32(&asyncTail);
+
+    while (tail != core_util_atomic_load_u32(&asyncHead)) {
+
+        uint16_t command = asyncQueue[tail % ASYNC_QUEUE_SIZE];
+        core_util_atomic_store_u32(&asyncTail, ++tail);
+
+        uint8_t byte = command & 0xff;
+
+        if ((command & ASYNC_KIND_MASK) == ASYNC_DATA) {
+
+            data[len++] = byte;
+            if (len == I2CInterface::MAX_BATCH_SIZE) {
+
+                con.send_buffer(data, len, 1);
+                len = 0;
+            }
+            continue;
+        }
+
+        if (len != 0) {
+
+            con.send_buffer(data, len, 1);
+            len = 0;
+        }
+
+        switch (command & ASYNC_KIND_MASK) {
+
+            case ASYNC_INSTRUCTION:
+
+                con.send_byte(byte, 0, EXEC_TIME);
+                break;
+
+            case ASYNC_LONG_INSTR:
+
+                con.send_byte(byte, 0, LONG_EXEC_TIME);
+                break;
+
+            case ASYNC_BACKLIGHT:
+
+                (byte != 0) ? con.enable_backlight() : con.disable_backlight();
+                break;
+
+            case ASYNC_BATCH:
+
+                if (byte == BATCH_BEGIN) {
+                    con.begin_batch();
+                }
+#if DEVICE_I2C_ASYNCH
+                else if (byte == BATCH_END_ASYNC) {
+                    con.end_batch_async(flushDone);
+                }
+#endif // DEVICE_I2C_ASYNCH
+                else {
+                    con.end_batch();
+                }
+                break;
+        }
+    }
+
+    if (len != 0) {
+        con.send_buffer(data, len, 1);
+    }
+}
+
+void
+HD44780LCD::async_thread_main() {
+
+    while (true) {
+
+        ThisThread::flags_wait_any(ASYNC_DRAIN_FLAG);
+
+        if (!asyncEnabled) {
+            break;
+        }
+
+        drain_async();
+    }
+}
+
+void
+HD44780LCD::inc_cursor_loc() {
+    cursorLoc = next_loc(cursorLoc);
+}
+
+void
+HD44780LCD::dec_cursor_loc() {
+    cursorLoc = prev_loc(cursorLoc);
+}
+
+void
+HD44780LCD::advance_cursor_loc() {
+
+    (cursorMovement & LCD_CURSOR_POS_INC)
+    ? inc_cursor_loc()
+    : dec_cursor_loc();
+}
+
+bool
+HD44780LCD::is_valid_pos(uint32_t r, uint32_t c) const {
+
+    if (r >= geometry.rows) {
+        return false;
+    }
+
+    // columns past the visible ones are allowed up to the end of the line the row lies in
+    auto orig = geometry.rowOffsets[r];
+    return c < (line_start(orig) + line_size() - orig);
+}
+
+uint32_t
+HD44780LCD::next_loc(uint32_t loc) const {
+
+    // the address counter moves on to the start of the other line (the same line in single-line mode)
+    auto start = line_start(loc);
+
+    ++loc;
+    if (loc >= (start + line_size())) {
+        loc = (geometry.is_two_line() && start == LCD_ORIG_ADDR_FIRST)
+                ? LCD_ORIG_ADDR_SECOND
+                : LCD_ORIG_ADDR_FIRST;
+    }
+
+    return loc;
+}
+
+uint32_t
+HD44780LCD::prev_loc(uint32_t loc) const {
+
+    // the address counter moves back to the end of the other line (the same line in single-line mode)
+    auto start = line_start(loc);
+
+    if (loc == start) {
+        return ((geometry.is_two_line() && start == LCD_ORIG_ADDR_FIRST)
+                ? LCD_ORIG_ADDR_SECOND
+                : LCD_ORIG_ADDR_FIRST)
+                + line_size() - 1;
+    }
+
+    return loc - 1;
+}
+
+uint32_t
+HD44780LCD::line_start(uint32_t loc) const {
+
+    if (!geometry.is_two_line()) {
+        return LCD_ORIG_ADDR_SINGLE;
+    }
+
+    return (loc >= LCD_ORIG_ADDR_SECOND)
+    ? LCD_ORIG_ADDR_SECOND
+    : LCD_ORIG_ADDR_FIRST;
+}
+
+uint32_t
+HD44780LCD::line_size() const {
+
+    return geometry.is_two_line()
+    ? LCD_LINE_SIZE
+    : LCD_LINE_SIZE_SINGLE;
+}
+
+uint32_t
+HD44780LCD::frame_index(uint32_t loc) const {
+
+    if (!geometry.is_two_line()) {
+        return loc - LCD_ORIG_ADDR_SINGLE;
+    }
+
+    return (loc >= LCD_ORIG_ADDR_SECOND)
+    ? (loc - LCD_ORIG_ADDR_SECOND + LCD_LINE_SIZE)
+    : (loc - LCD_ORIG_ADDR_FIRST);
+}
+
+uint32_t
+HD44780LCD::frame_loc(uint32_t idx) const {
+
+    if (!geometry.is_two_line()) {
+        return idx + LCD_ORIG_ADDR_SINGLE;
+    }
+
+    return (idx >= LCD_LINE_SIZE)
+    ? (idx - LCD_LINE_SIZE + LCD_ORIG_ADDR_SECOND)
+    : (idx + LCD_ORIG_ADDR_FIRST);
+}
+
+void
+HD44780LCD::store_cell(uint8_t byte, bool sent) {
+
+    auto idx = frame_index(cursorLoc);
+
+    frame[idx] = byte;
+
+    if (sent) {
+        frameShown[idx] = byte;
+    }
+    else {
+        frameDirty[idx / 8] |= (1 << (idx % 8));
+    }
+}
+
+void
+HD44780LCD::clear_frame(bool sent) {
+
+    memset(frame, ' ', DDRAM_SIZE);
+
+    if (sent) {
+        memset(frameShown, ' ', DDRAM_SIZE);
+    }
+    else {
+        memset(frameDirty, 0xff, sizeof(frameDirty));
+    }
+}
+
+// private class methods
+
+HD44780LCD::I2CInterface::I2CInterface(PinName I2cSda, PinName I2cScl, uint8_t addr, uint32_t frequency,
+        const PinMap &pinMap)
+        : ownedCon(std::in_place, I2cSda, I2cScl)
+        , con(*ownedCon)
+        , sda {I2cSda}
+        , scl {I2cScl}
+        , frequency {(frequency < MAX_I2C_FREQ) ? frequency : MAX_I2C_FREQ}
+        , addr {addr}
+        , backlightMask {0}
+        , pins {pinMap}
+        , rsMask {(uint8_t)(1 << pinMap.rs)}
+        , rwMask {(uint8_t)(1 << pinMap.rw)}
+        , enMask {(uint8_t)(1 << pinMap.en)}
+        , blMask {(uint8_t)(1 << pinMap.backlight)}
+{
+    setup();
+    con.frequency(this->frequency);
+}
+
+HD44780LCD::I2CInterface::I2CInterface(I2C &bus, uint8_t addr, const PinMap &pinMap)
+        : con(bus)
+        , addr {addr}
+        , backlightMask {0}
+        , pins {pinMap}
+        , rsMask {(uint8_t)(1 << pinMap.rs)}
+        , rwMask {(uint8_t)(1 << pinMap.rw)}
+        , enMask {(uint8_t)(1 << pinMap.en)}
+        , blMask {(uint8_t)(1 << pinMap.backlight)}
+{
+    setup();
+}
+
+void
+HD44780LCD::I2CInterface::setup() {
+
+    // the data pins are spread over the outputs once, so that encoding only needs a lookup
+    for (uint8_t nibble = 0; nibble < 16; ++nibble) {
+        nibbleOutputs[nibble] = pins.encode_nibble(nibble);
+    }
+}
+
+
+void
+HD44780LCD::I2CInterface::send_byte(uint8_t byte, uint8_t isData, std::chrono::microseconds execTime) {
+
+    uint8_t buf[BYTE_PACKET_SIZE];
+
+    count_bytes(isData, 1);
+
+    // both nibbles (along with the EN pulses) are sent in a single transaction, the PC8574 latches each
+    // byte onto its outputs as soon as it is received
+    encode_byte(byte, isData, buf);
+
+    // instructions that take long to execute can not be followed by other transfers within a transaction
+    if (batching && execTime <= EXEC_TIME) {
+
+        append(buf, BYTE_PACKET_SIZE);
+        return;
+    }
+
+    const auto begin = stats_begin();
+
+    commit();
+
+    wait_ready();
+    write(buf, BYTE_PACKET_SIZE);
+    mark_busy(execTime);
+
+    lastOutput = buf[BYTE_PACKET_SIZE - 1];
+
+    count_blocked(begin);
+}
+
+void
+HD44780LCD::I2CInterface::send_buffer(const uint8_t *buf, uint32_t len, uint8_t isData) {
+
+    uint8_t packets[MAX_BATCH_SIZE * BYTE_PACKET_SIZE];
+
+    count_bytes(isData, len);
+
+    // within a transaction, consecutive bytes are separated by at least 6 byte-times on the bus (over 130us
+    // at 400kHz), which is longer than the time the LCD takes to execute each of them
+
+    if (batching) {
+
+        for (const uint8_t *ptr = buf; ptr != &buf[len]; ++ptr) {
+
+            encode_byte(*ptr, isData, packets);
+            append(packets, BYTE_PACKET_SIZE);
+        }
+        return;
+    }
+
+    const auto begin = stats_begin();
+
+    while (len != 0) {
+
+        uint32_t count = (len < MAX_BATCH_SIZE) ? len : MAX_BATCH_SIZE;
+
+        for (uint32_t i = 0; i < count; ++i) {
+            encode_byte(buf[i], isData, &packets[i * BYTE_PACKET_SIZE]);
+        }
+
+        wait_ready();
+        write(packets, count * BYTE_PACKET_SIZE);
+        mark_busy(EXEC_TIME);
+
+        lastOutput = packets[(count * BYTE_PACKET_SIZE) - 1];
+
+        buf += count;
+        len -= count;
+    }
+
+    count_blocked(begin);
+}
+
+void
+HD44780LCD::I2CInterface::send_raw(const uint8_t *outputs, uint32_t len, bool backlight) {
+
+    const uint8_t flip = (backlight ? blMask : 0) ^ backlightMask;
+    const auto begin = stats_begin();
+
+    commit();
+    wait_ready();
+
+    if (len == 0) {
+
+        count_blocked(begin);
+        return;
+    }
+
+    lastOutput = outputs[len - 1] ^ flip;
+
+    if (flip == 0) {
+
+        write(outputs, len);
+        mark_busy(EXEC_TIME);
+
+        count_blocked(begin);
+        return;
+    }
+
+    // the outputs are stored in flash, so the backlight is corrected in chunks copied onto the stack
+    uint8_t packets[MAX_BATCH_SIZE * BYTE_PACKET_SIZE];
+
+    while (len != 0) {
+
+        uint32_t count = (len < sizeof(packets)) ? len : sizeof(packets);
+
+        for (uint32_t i = 0; i < count; ++i) {
+            packets[i] = outputs[i] ^ flip;
+        }
+
+        wait_ready();
+        write(packets, count);
+        mark_busy(EXEC_TIME);
+
+        outputs += count;
+        len -= count;
+    }
+
+    count_blocked(begin);
+}
+
+void
+HD44780LCD::I2CInterface::send_nibble(uint8_t nibble, uint8_t isData, std::chrono::microseconds execTime) {
+
+    uint8_t result = nibbleOutputs[nibble & 0xf] | (isData ? rsMask : 0) | backlightMask;
+    uint8_t buf[NIBBLE_PACKET_SIZE] = {result, (uint8_t)(result | enMask), result};
+
+    const auto begin = stats_begin();
+
+    count_bytes(isData, 1);
+    commit();
+
+    wait_ready();
+    write(buf, NIBBLE_PACKET_SIZE);
+    mark_busy(execTime);
+
+    lastOutput = buf[NIBBLE_PACKET_SIZE - 1];
+
+    count_blocked(begin);
+}
+
+void
+HD44780LCD::I2CInterface::enable_backlight() {
+
+    backlightMask = blMask;
+    write_backlight();
+}
+
+void
+HD44780LCD::I2CInterface::disable_backlight() {
+
+    backlightMask = 0;
+    write_backlight();
+}
+
+void
+HD44780LCD::I2CInterface::toggle_backlight() {
+
+    backlightMask ^= blMask;
+    write_backlight();
+}
+
+const HD44780LCD::PinMap &
+HD44780LCD::I2CInterface::get_pin_map() const {
+    return pins;
 }
 
 bool
 HD44780LCD::I2CInterface::is_backlight_on() const {
     return backlightMask != 0;
 }
+
+void
+HD44780LCD::I2CInterface::begin_batch() {
+
+    // the stream may still be in use by an asynchronous transfer
+    wait_transfer();
+    batching = true;
+}
+
+void
+HD44780LCD::I2CInterface::end_batch(bool repeated) {
+
+    const auto begin = stats_begin();
+
+    commit(repeated);
+    batching = false;
+
+    count_blocked(begin);
+}
+
+bool
+HD44780LCD::I2CInterface::has_pending() const {
+    return streamLen != 0;
+}
+
+#if DEVICE_I2C_ASYNCH
+void
+HD44780LCD::I2CInterface::end_batch_async(Callback<void(int)> done) {
+
+    batching = false;
+
+    if (streamLen == 0) {
+
+        if (done) {
+            done(I2C_EVENT_TRANSFER_COMPLETE);
+        }
+        return;
+    }
+
+    wait_ready();
+
+    transferDone = done;
+    transferActive = true;
+
+    if (con.transfer(addr, (const char *)stream, streamLen, nullptr, 0,
+            callback(this, &HD44780LCD::I2CInterface::on_transfer_done), I2C_EVENT_ALL) != 0) {
+
+        // the peripheral is busy with another transfer, send the stream from the calling thread instead
+        transferActive = false;
+
+        write(stream, streamLen);
+        mark_busy(EXEC_TIME);
+
+        if (done) {
+            done(I2C_EVENT_TRANSFER_COMPLETE);
+        }
+    }
+
+    streamLen = 0;
+}
+#endif // DEVICE_I2C_ASYNCH
+
+void
+HD44780LCD::I2CInterface::reset_bus() {
+
+    if (!ownedCon) {
+        return;
+    }
+
+    wait_transfer();
+
+    // the bus is initialized again in place, so that the reference to it stays valid
+    ownedCon.reset();
+    ownedCon.emplace(sda, scl);
+    con.frequency(frequency);
+}
+
+void
+HD44780LCD::I2CInterface::wait_transfer() {
+
+#if DEVICE_I2C_ASYNCH
+    while (transferActive) {
+        transferFlags.wait_any(TRANSFER_DONE_FLAG);
+    }
+#endif // DEVICE_I2C_ASYNCH
+}
+
+void
+HD44780LCD::I2CInterface::encode_byte(uint8_t byte, uint8_t isData, uint8_t *dst) const {
+
+    for (uint32_t _ = 0; _ <= 4; _ += 4) {
+
+        auto nibble = (byte >> (4 ^ _)) & 0xf;
+        uint8_t result = nibbleOutputs[nibble] | (isData ? rsMask : 0) | backlightMask;
+
+        *dst++ = result;
+        *dst++ = result | enMask;
+        *dst++ = result;
+    }
+}
+
+int
+HD44780LCD::I2CInterface::write(const uint8_t *buf, uint32_t len, bool repeated) {
+
+    for (uint32_t attempt = 0; ; ++attempt) {
+
+        int result = con.write(addr, (const char *)buf, len, repeated);
+        count_write(result);
+
+        if (result == 0) {
+
+            heldOutput = buf[len - 1];
+            return 0;
+        }
+
+        // sending the outputs again from the start would repeat the strobes of any part of them that was latched, so
+        // the write is only retried if none of it reached the LCD (the LCD is resynchronized otherwise)
+        if (attempt == HD44780LCD_I2C_RETRIES || may_have_latched(buf, len)) {
+
+            set_fault();
+            return result;
+        }
+    }
+}
+
+bool
+HD44780LCD::I2CInterface::may_have_latched(const uint8_t *buf, uint32_t len) {
+
+    char port;
+
+    // the write only reports that it failed, so the outputs are read back (without the backlight output, which the
+    // transistor it drives may pull low), a chip that does not respond may have latched anything
+    if (con.read(addr, &port, 1) != 0) {
+        return true;
+    }
+
+    const uint8_t mask = ~blMask;
+    const uint8_t held = (uint8_t)port & mask;
+
+    if (held != (heldOutput & mask)) {
+        return true;
+    }
+
+    // the chip holds the outputs from before the write, which could also be where a part of it that strobed the LCD
+    // ended
+    bool strobed = false;
+    uint8_t prev = heldOutput;
+
+    for (const uint8_t *ptr = buf; ptr != &buf[len]; ++ptr) {
+
+        strobed |= (prev & enMask) && !(*ptr & enMask);
+        if (strobed && (*ptr & mask) == held) {
+            return true;
+        }
+
+        prev = *ptr;
+    }
+
+    return false;
+}
+
+uint8_t
+HD44780LCD::I2CInterface::poll_status() {
+
+    // the data pins of the PC8574 are quasi-bidirectional, driving them high lets the LCD pull them low
+    const uint8_t idle = nibbleOutputs[0xf] | rwMask | backlightMask;
+    const uint8_t strobe[2] = {idle, (uint8_t)(idle | enMask)};
+
+    uint8_t nibbles[2];
+    bool failed = false;
+
+    // the bus is held for the whole read, so that other devices sharing it can not interleave with the strobes
+    con.lock();
+
+    // the status is read in two halves (higher nibble first), each while EN is held high
+    for (uint8_t &nibble : nibbles) {
+
+        char port = 0;
+
+        int result = write(strobe, 2);
+        if (result == 0) {
+            result = con.read(addr, &port, 1);
+        }
+
+        // EN is brought low again even after a failure, so that the LCD is not left in the middle of a read
+        result |= write(&idle, 1);
+
+        failed |= (result != 0);
+        nibble = pins.decode_nibble((uint8_t)port);
+    }
+
+    con.unlock();
+
+    lastOutput = idle;
+
+    // a status that could not be read is not reported, the execution times are waited out until the LCD has been
+    // resynchronized instead
+    if (failed) {
+
+        set_fault();
+        return 0;
+    }
+
+    return (nibbles[0] << 4) | nibbles[1];
+}
+
+void
+HD44780LCD::I2CInterface::append(const uint8_t *buf, uint32_t len) {
+
+    if ((streamLen + len) > HD44780LCD_STREAM_SIZE) {
+        commit();
+    }
+
+    memcpy(&stream[streamLen], buf, len);
+    streamLen += len;
+
+    lastOutput = buf[len - 1];
+}
+
+void
+HD44780LCD::I2CInterface::write_backlight() {
+
+    // the data, RS and EN outputs are held where the last transfer left them, so that only the backlight changes
+    uint8_t output = (lastOutput & ~blMask) | backlightMask;
+
+    if (batching) {
+
+        append(&output, 1);
+        return;
+    }
+
+    commit();
+    wait_transfer();
+
+    write(&output, 1);
+    lastOutput = output;
+}
+
+void
+HD44780LCD::I2CInterface::commit(bool repeated) {
+
+    if (streamLen == 0) {
+        return;
+    }
+
+    wait_ready();
+    write(stream, streamLen, repeated);
+    mark_busy(EXEC_TIME);
+
+    streamLen = 0;
+}
+
+#if DEVICE_I2C_ASYNCH
+void
+HD44780LCD::I2CInterface::on_transfer_done(int event) {
+
+    mark_busy(EXEC_TIME);
+
+    // the calling thread does not touch the counters while the transfer is in progress
+    count_write(event & ~I2C_EVENT_TRANSFER_COMPLETE);
+
+    if ((event & ~I2C_EVENT_TRANSFER_COMPLETE) != 0) {
+        set_fault();
+    }
+    else {
+        heldOutput = lastOutput;
+    }
+
+    transferActive = false;
+    transferFlags.set(TRANSFER_DONE_FLAG);
+
+    if (transferDone) {
+        transferDone(event);
+    }
+}
+#endif // DEVICE_I2C_ASYNCH
@@ -2,7 +2,8 @@
  * @file                    HD44780LCD.h
  * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
  *
- * @brief                   Simple Library to use a 16x2 LCD display driven by the HD44780 driver with MBed OS
+ * @brief                   Simple Library to use a character LCD display (such as 16x2 or 20x4) driven by the HD44780
+ *                          driver with MBed OS
  *
  * @copyright               Copyright (c) 2023
  *
@@ -13,97 +14,723 @@
 
 #include "mbed.h"
 
+#include "HD44780Bus.h"
+
+#include <optional>
+
+class HD44780Screen;
+
+#ifndef HD44780LCD_ASYNC_QUEUE_SIZE
+/** Number of commands (instructions or characters) that can be queued in asynchronous mode (must be a power of 2) */
+#define HD44780LCD_ASYNC_QUEUE_SIZE     128
+#endif
+
+#ifndef HD44780LCD_STREAM_SIZE
+/** Number of PC8574 outputs (6 per character or instruction) that can be collected into a single I2C transaction */
+#define HD44780LCD_STREAM_SIZE          256
+#endif
+
+#ifndef HD44780LCD_DIMMING_LEVELS
+/** Number of steps in a period of the backlight dimming (the levels range from 0 to this number) */
+#define HD44780LCD_DIMMING_LEVELS       8
+#endif
+
+#ifndef HD44780LCD_I2C_RETRIES
+/** Number of times an I2C write that did not reach the LCD at all is retried before the LCD is resynchronized */
+#define HD44780LCD_I2C_RETRIES          2
+#endif
+
+#ifndef HD44780LCD_ASYNC_STACK_SIZE
+/** Size of the stack of the thread that sends queued commands in asynchronous mode */
+#define HD44780LCD_ASYNC_STACK_SIZE     1024
+#endif
+
 /**
- * @brief                   Class that provides a simple interface to use a 16x2 LCD driven with the HD44780 driver
+ * @brief                   Class that provides a simple interface to use a character LCD driven with the HD44780 driver
+ *
+ * @remark                  Every method that changes the LCD (including the stream methods, such as printf and puts)
+ *                          locks the built-in mutex of the LCD by itself, calls that must not be interleaved with
+ *                          those of other threads (such as a whole screen update) are grouped within a
+ *                          ```HD44780LCD::Transaction``` (or between ```lock()``` and ```unlock()```), which also sends
+ *                          them in a single batch
  *
  */
 class HD44780LCD
         : public Stream
 {
 
+    friend class HD44780LCDGroup;
+    friend class HD44780Pager;
+
+public:
+
+    /**
+     * @brief               Mapping of the outputs (P0 - P7) of the PC8574 chip to the pins of the LCD, which differs
+     *                      between backpacks
+     *
+     */
+    struct PinMap {
+
+        /** index of the output connected to the RS pin of the LCD */
+        uint8_t     rs;
+        /** index of the output connected to the RW pin of the LCD */
+        uint8_t     rw;
+        /** index of the output connected to the EN pin of the LCD */
+        uint8_t     en;
+        /** index of the output that switches the backlight of the LCD */
+        uint8_t     backlight;
+        /** indices of the outputs connected to the DB4 - DB7 pins of the LCD */
+        uint8_t     data[4];
+
+        /**
+         * @brief           Get the outputs that present a nibble on the DB4 - DB7 pins of the LCD
+         *
+         * @param nibble    Nibble to present
+         * @return uint8_t  Outputs of the PC8574 chip
+         */
+        constexpr uint8_t   encode_nibble(uint8_t nibble) const {
+
+            uint8_t outputs = 0;
+            for (uint32_t i = 0; i < 4; ++i) {
+                outputs |= ((nibble >> i) & 1) << data[i];
+            }
+            return outputs;
+        }
+
+        /**
+         * @brief           Get the nibble present on the DB4 - DB7 pins of the LCD from the outputs of the PC8574 chip
+         *
+         * @param outputs   Outputs of the PC8574 chip (as read from it)
+         * @return uint8_t  Nibble present on the pins
+         */
+        constexpr uint8_t   decode_nibble(uint8_t outputs) const {
+
+            uint8_t nibble = 0;
+            for (uint32_t i = 0; i < 4; ++i) {
+                nibble |= ((outputs >> data[i]) & 1) << i;
+            }
+            return nibble;
+        }
+
+        /**
+         * @brief           Check whether two mappings are the same
+         *
+         * @param other     Mapping to compare with
+         * @return true     If all outputs are mapped to the same pins
+         * @return false    Otherwise
+         */
+        constexpr bool      operator==(const PinMap &other) const {
+
+            for (uint32_t i = 0; i < 4; ++i) {
+                if (data[i] != other.data[i]) {
+                    return false;
+                }
+            }
+            return rs == other.rs && rw == other.rw && en == other.en && backlight == other.backlight;
+        }
+    };
+
+    /** the mapping used by most backpacks (P0 - RS, P1 - RW, P2 - EN, P3 - backlight, P4 to P7 - DB4 to DB7) */
+    static constexpr PinMap DEFAULT_PIN_MAP {0, 1, 2, 3, {4, 5, 6, 7}};
+
+    /**
+     * @brief               Layout of the rows and columns of a module in the DDRAM of the LCD, which differs between
+     *                      modules
+     *
+     * @remark              Modules with a row starting at 0x40 or later are driven in 2-line mode (two lines of 40
+     *                      characters starting at 0x00 and 0x40), all others are driven in 1-line mode (a single line
+     *                      of 80 characters starting at 0x00)
+     *
+     */
+    struct Geometry {
+
+        /** number of rows on the module (up to 4) */
+        uint8_t     rows;
+        /** number of visible columns on the module */
+        uint8_t     cols;
+        /** address in the DDRAM of the first character of each row */
+        uint8_t     rowOffsets[4];
+
+        /**
+         * @brief           Get the address in the DDRAM of the character at a position on the module
+         *
+         * @param r         Row of the character
+         * @param c         Column of the character
+         * @return uint8_t  Address in the DDRAM
+         */
+        constexpr uint8_t   address(uint8_t r, uint8_t c) const {
+
+            return rowOffsets[r] + c;
+        }
+
+        /**
+         * @brief           Check whether the LCD needs to be driven in 2-line mode for this layout
+         *
+         * @return true     If any row starts in the second line (at 0x40 or later)
+         * @return false    If all rows start in the first line
+         */
+        constexpr bool      is_two_line() const {
+
+            for (uint32_t r = 0; r < rows; ++r) {
+                if (rowOffsets[r] >= 0x40) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief           Check whether every row starts a separate line of the DDRAM (so that shifting the display
+         *                  moves each row around within its own line)
+         *
+         * @return true     If there are at most two rows, starting at 0x00 and 0x40
+         * @return false    Otherwise
+         */
+        constexpr bool      has_row_per_line() const {
+
+            if (rows > 2) {
+                return false;
+            }
+            for (uint32_t r = 0; r < rows; ++r) {
+                if (rowOffsets[r] != (r * 0x40)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief           Check whether two layouts are the same
+         *
+         * @param other     Layout to compare with
+         * @return true     If the layouts have the same rows, columns and row offsets
+         * @return false    Otherwise
+         */
+        constexpr bool      operator==(const Geometry &other) const {
+
+            if (rows != other.rows || cols != other.cols) {
+                return false;
+            }
+            for (uint32_t r = 0; r < rows; ++r) {
+                if (rowOffsets[r] != other.rowOffsets[r]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    /** 16x1 modules that use a single line of the DDRAM */
+    static constexpr Geometry GEOMETRY_16X1 {1, 16, {0x00}};
+    /** 16x2 modules (default) */
+    static constexpr Geometry GEOMETRY_16X2 {2, 16, {0x00, 0x40}};
+    /** 16x4 modules */
+    static constexpr Geometry GEOMETRY_16X4 {4, 16, {0x00, 0x40, 0x10, 0x50}};
+    /** 20x2 modules */
+    static constexpr Geometry GEOMETRY_20X2 {2, 20, {0x00, 0x40}};
+    /** 20x4 modules */
+    static constexpr Geometry GEOMETRY_20X4 {4, 20, {0x00, 0x40, 0x14, 0x54}};
+    /** 40x2 modules */
+    static constexpr Geometry GEOMETRY_40X2 {2, 40, {0x00, 0x40}};
+
+    /** Counters of the transfers made to the LCD (see ```HD44780LCD::get_stats()```) */
+    using Stats = HD44780Bus::Stats;
+
+    /**
+     * @brief               Translation applied to the characters written through the stream methods (printf, puts,
+     *                      etc.), which depends on the character ROM of the LCD
+     *
+     */
+    enum class Charset : uint8_t {
+
+        /** bytes are sent as they are (default) */
+        RAW,
+        /** UTF-8 input is mapped onto the A00 ROM (Japanese, with katakana and some Greek letters) */
+        UTF8_A00,
+        /** UTF-8 input is mapped onto the A02 ROM (European, with most of the Latin-1 letters) */
+        UTF8_A02,
+    };
+
+private:
+
     /** the default address of the I2C Peripheral that controls the LCD */
     static constexpr uint8_t DEFAULT_I2C_ADDR	= (0x27<<1);
 
+    /** the default frequency of the I2C bus (standard mode) */
+    static constexpr uint32_t DEFAULT_I2C_FREQ  = 100000;
+    /** the maximum frequency of the I2C bus supported by the PC8574 chip (fast mode) */
+    static constexpr uint32_t MAX_I2C_FREQ      = 400000;
+
+    /** time taken by the LCD to execute most instructions and data writes (datasheet value, fosc = 270kHz) */
+    static constexpr std::chrono::microseconds  EXEC_TIME       = HD44780Bus::EXEC_TIME;
+    /** time taken by the LCD to execute the clear display and return home instructions (datasheet value, fosc = 270kHz) */
+    static constexpr std::chrono::microseconds  LONG_EXEC_TIME  = HD44780Bus::LONG_EXEC_TIME;
+
+    /** time taken by the LCD to be ready for the initialization sequence after power rises to 2.7V (datasheet value) */
+    static constexpr std::chrono::milliseconds  POWER_ON_TIME       {40};
+    /** time taken by the LCD to execute the first function set of the initialization sequence (datasheet value) */
+    static constexpr std::chrono::microseconds  RESYNC_TIME_FIRST   {4100};
+    /** time taken by the LCD to execute the other function sets of the initialization sequence (datasheet value) */
+    static constexpr std::chrono::microseconds  RESYNC_TIME         {100};
+
+    /** time between consecutive steps of the backlight dimming (a whole period of 8 steps lasts 16ms) */
+    static constexpr std::chrono::milliseconds  DIMMING_PERIOD      {2};
+
     /**
-     * @brief               Class that provides an interface to use the display via the PC8574 I2C-driven chip
+     * @brief               Class that provides an interface to use the display via the PC8574 I2C-driven chip (the
+     *                      transport created by the I2C constructors of ```HD44780LCD```)
+     *
+     * @remark              All state (including the buffers used to encode transfers) is held per instance or on the
+     *                      stack, so separate instances can be used from separate threads without any locking
      *
      */
-    class I2CInterface {
+    class I2CInterface : public HD44780Bus {
 
+        /** I2C bus created for the PC8574 chip (empty if a bus shared with other devices is used) */
+        std::optional<I2C>  ownedCon;
         /** I2C bus being used to connect to the PC8574 chip */
-        I2C         con;
+        I2C         &con;
+        /** Pins of the I2C bus created for the PC8574 chip (used to create it again on recovery) */
+        PinName     sda {NC};
+        /** Pins of the I2C bus created for the PC8574 chip (used to create it again on recovery) */
+        PinName     scl {NC};
+        /** Frequency of the I2C bus created for the PC8574 chip */
+        uint32_t    frequency {0};
 
         /** Address of the PC8574 chip on the I2C Bus */
         uint8_t     addr;
         /** Bitmask holding the status of the backlight */
         uint8_t     backlightMask;
+        /** Outputs last written to the PC8574 chip (which it holds until the next write) */
+        uint8_t     lastOutput {0};
+        /** Outputs held by the PC8574 chip after the last write that it acknowledged (all high on power-up) */
+        uint8_t     heldOutput {0xff};
+
+        /** Mapping of the outputs of the PC8574 chip to the pins of the LCD */
+        PinMap      pins;
+        /** Outputs that present each nibble on the data pins of the LCD (computed once from ```pins```) */
+        uint8_t     nibbleOutputs[16];
+        /** Output connected to the RS pin of the LCD */
+        uint8_t     rsMask;
+        /** Output connected to the RW pin of the LCD */
+        uint8_t     rwMask;
+        /** Output connected to the EN pin of the LCD */
+        uint8_t     enMask;
+        /** Output that switches the backlight of the LCD */
+        uint8_t     blMask;
+
+        /** PC8574 outputs collected while batching, sent as a single I2C transaction */
+        uint8_t     stream[HD44780LCD_STREAM_SIZE];
+        /** Number of outputs collected in ```stream``` */
+        uint32_t    streamLen {0};
+        /** Whether transfers are being collected in ```stream``` instead of being sent immediately */
+        bool        batching {false};
+
+#if DEVICE_I2C_ASYNCH
+        /** Event flags used to signal the completion of an asynchronous transfer */
+        EventFlags  transferFlags;
+        /** Whether an asynchronous transfer of ```stream``` is in progress */
+        volatile bool       transferActive {false};
+        /** Callback to invoke on completion of the asynchronous transfer */
+        Callback<void(int)> transferDone;
+#endif // DEVICE_I2C_ASYNCH
+
+        /** Number of bytes sent to the PC8574 chip to transfer a nibble (setup, EN high, EN low) */
+        static constexpr uint32_t   NIBBLE_PACKET_SIZE  = 3;
+        /** Number of bytes sent to the PC8574 chip to transfer a byte (two nibbles) */
+        static constexpr uint32_t   BYTE_PACKET_SIZE    = 2 * NIBBLE_PACKET_SIZE;
+
+        /**
+         * @brief           Encode a byte into the sequence of PC8574 outputs that transfers it to the LCD
+         *
+         * @param byte      Byte to encode (data or instruction indicated by ```isData```)
+         * @param isData    Whether the byte was data or an instruction
+         * @param dst       Buffer of at least ```BYTE_PACKET_SIZE``` bytes to store the sequence in
+         */
+        void    encode_byte(uint8_t byte, uint8_t isData, uint8_t *dst) const;
+
+        /**
+         * @brief           Read the busy flag and address counter of the LCD without waiting for it to be ready
+         *
+         * @remark          Every transfer of the read is checked, a failure is recorded as a fault
+         *
+         * @return          Busy flag in the most significant bit, address counter in the remaining bits (0 if the
+         *                  read failed)
+         */
+        uint8_t poll_status() override;
+
+        /**
+         * @brief           Append encoded outputs to ```stream```, sending the collected outputs first if they do not fit
+         *
+         * @param buf       Pointer to the encoded outputs
+         * @param len       Number of outputs to append
+         */
+        void    append(const uint8_t *buf, uint32_t len);
+
+        /**
+         * @brief           Send the outputs collected in ```stream``` in a single I2C transaction
+         *
+         * @param repeated  Whether to end the transaction with a repeated start instead of a stop condition (so that
+         *                  the next transaction on the bus follows immediately)
+         */
+        void    commit(bool repeated = false) override;
+
+        /**
+         * @brief           Write the state of the backlight to the PC8574 chip, leaving the other outputs as the last
+         *                  transfer left them (collected into ```stream``` while batching)
+         *
+         */
+        void    write_backlight();
+
+        /**
+         * @brief           Write outputs to the PC8574 chip in a single I2C transaction, retrying up to
+         *                  ```HD44780LCD_I2C_RETRIES``` times while the chip does not acknowledge its address (and
+         *                  counting it if the counters are enabled)
+         *
+         * @remark          A write that fails is only sent again if none of it can have reached the LCD (see
+         *                  ```may_have_latched()```), since repeating the strobes of a latched part would leave the LCD
+         *                  out of step with the transport
+         * @remark          A failure that may have been latched, or that persists after the retries, is recorded as a
+         *                  fault (so that the LCD is resynchronized)
+         *
+         * @param buf       Pointer to the outputs
+         * @param len       Number of outputs
+         * @param repeated  Whether to end the transaction with a repeated start (without releasing the bus)
+         * @return int      0 on success, non-zero if the transaction failed (such as when the chip does not ACK)
+         */
+        int     write(const uint8_t *buf, uint32_t len, bool repeated = false);
+
+        /**
+         * @brief           Check whether a part of a failed write may have reached the LCD, by reading back the outputs
+         *                  held by the PC8574 chip
+         *
+         * @remark          The write can only be sent again if the chip still holds the outputs from before it, and no
+         *                  part of it that pulsed EN (strobing the LCD) ends with the same outputs
+         *
+         * @param buf       Pointer to the outputs of the failed write
+         * @param len       Number of outputs
+         * @return true     If some of the outputs may have been latched, or the chip does not respond
+         * @return false    If none of them reached the LCD
+         */
+        bool    may_have_latched(const uint8_t *buf, uint32_t len);
+
+        /**
+         * @brief           Compute the outputs of each nibble (common to all constructors)
+         *
+         */
+        void    setup();
+
+#if DEVICE_I2C_ASYNCH
+        /**
+         * @brief           Handle the completion of an asynchronous transfer (called from ISR context)
+         *
+         * @param event     I2C events that occured during the transfer
+         */
+        void    on_transfer_done(int event);
+#endif // DEVICE_I2C_ASYNCH
 
     public:
 
+        /** Maximum number of bytes (characters) packed into a single I2C transaction by ```send_buffer()``` */
+        static constexpr uint32_t   MAX_BATCH_SIZE      = 16;
+
         /**
          * @brief           Construct a new I2CInterface object
          *
          * @param I2cSda    Microcontroller Pin to which the SDA (Serial Data) Pin of the LCD is connected (must be an SDA Pin)
          * @param I2cScl    Microcontroller Pin to which the SCL (Serial Clock) Pin of the LCD is connected (must be an SCL Pin)
          * @param addr      Address of the PC8574 chip on the I2C Bus
+         * @param frequency Frequency of the I2C bus in Hz (limited to ```MAX_I2C_FREQ```)
+         * @param pinMap    Mapping of the outputs of the PC8574 chip to the pins of the LCD
          */
-        I2CInterface(PinName I2cSda, PinName I2cScl, uint8_t addr = DEFAULT_I2C_ADDR);
+        I2CInterface(PinName I2cSda, PinName I2cScl, uint8_t addr = DEFAULT_I2C_ADDR, uint32_t frequency = DEFAULT_I2C_FREQ,
+                const PinMap &pinMap = DEFAULT_PIN_MAP);
+
+        /**
+         * @brief           Construct a new I2CInterface object on a bus shared with other devices
+         *
+         * @param bus       I2C bus to which the PC8574 chip is connected (its frequency is left unchanged)
+         * @param addr      Address of the PC8574 chip on the I2C Bus
+         * @param pinMap    Mapping of the outputs of the PC8574 chip to the pins of the LCD
+         */
+        I2CInterface(I2C &bus, uint8_t addr, const PinMap &pinMap = DEFAULT_PIN_MAP);
 
         /**
          * @brief           Send a byte (data or instruction) to the LCD (two nibbles in half-bus mode)
          *
          * @param byte      Byte to send (data or instruction indicated by ```isData```)
          * @param isData    Whether the byte was data or an instruction
+         * @param execTime  Time the LCD takes to execute the byte, subsequent transfers are delayed until it elapses
          */
-        void    send_byte(uint8_t byte, uint8_t isData);
+        void    send_byte(uint8_t byte, uint8_t isData, std::chrono::microseconds execTime = EXEC_TIME) override;
+
+        /**
+         * @brief           Send an array of bytes (data or instructions) to the LCD, packing as many as possible
+         *                  into a single I2C transaction
+         *
+         * @param buf       Pointer to array of bytes
+         * @param len       Number of bytes to pick from the buffer
+         * @param isData    Whether the bytes are data or instructions
+         */
+        void    send_buffer(const uint8_t *buf, uint32_t len, uint8_t isData) override;
+
+        /**
+         * @brief           Send outputs of the PC8574 chip that have already been encoded (such as those of an
+         *                  ```HD44780Screen```), in as few I2C transactions as possible
+         *
+         * @remark          The outputs must not contain instructions that take long to execute
+         *
+         * @param outputs   Pointer to the outputs
+         * @param len       Number of outputs to send
+         * @param backlight Whether the backlight is switched on in the outputs (they are sent with the backlight bit
+         *                  flipped if this differs from the state of the backlight)
+         */
+        void    send_raw(const uint8_t *outputs, uint32_t len, bool backlight);
 
         /**
          * @brief           Send a nibble (data or instruction) to the LCD
          *
          * @param nibble    Nibble to send (data or instruction indicated by ```isData```)
          * @param isData    Whether the byte was data or an instruction
+         * @param execTime  Time the LCD takes to execute the nibble, subsequent transfers are delayed until it elapses
          */
-        void    send_nibble(uint8_t nibble, uint8_t isData);
+        void    send_nibble(uint8_t nibble, uint8_t isData, std::chrono::microseconds execTime = EXEC_TIME) override;
 
         /**
          * @brief           Enable the LCD's backlight
          *
          */
-        void    enable_backlight();
+        void    enable_backlight() override;
 
         /**
          * @brief           Disable the LCD's backlight
          *
          */
-        void    disable_backlight();
+        void    disable_backlight() override;
 
         /**
          * @brief           Toggle the LCD's backlight
          *
          */
-        void    toggle_backlight();
+        void    toggle_backlight() override;
+
+        /**
+         * @brief           Get the mapping of the outputs of the PC8574 chip to the pins of the LCD
+         *
+         * @return          Mapping of the outputs
+         */
+        const PinMap &get_pin_map() const;
 
         /**
          * @brief           Check the state of the LCD's backlight
          *
          * @return          true if the backlight is switched on, false otherwise
          */
-        bool    is_backlight_on() const;
+        bool    is_backlight_on() const override;
+
+        /**
+         * @brief           Start collecting subsequent transfers (except those that take long to execute) into a single
+         *                  I2C transaction
+         *
+         */
+        void    begin_batch() override;
+
+        /**
+         * @brief           Stop collecting transfers and send the ones that have been collected
+         *
+         * @param repeated  Whether to end the transaction with a repeated start instead of a stop condition
+         */
+        void    end_batch(bool repeated = false) override;
+
+        /**
+         * @brief           Check whether any transfers have been collected but not sent yet
+         *
+         * @return true     If transfers are waiting to be sent
+         * @return false    Otherwise
+         */
+        bool    has_pending() const override;
+
+#if DEVICE_I2C_ASYNCH
+        /**
+         * @brief           Stop collecting transfers and start sending the ones that have been collected in the
+         *                  background, returning immediately
+         *
+         * @param done      Callback to invoke (from ISR context) with the I2C events once the transfer completes
+         */
+        void    end_batch_async(Callback<void(int)> done) override;
+#endif // DEVICE_I2C_ASYNCH
+
+        /**
+         * @brief           Wait for the asynchronous transfer in progress (if any) to complete
+         *
+         */
+        void    wait_transfer() override;
+
+        /**
+         * @brief           Create the I2C bus again (if it was created for the PC8574 chip), which releases a stuck bus on
+         *                  most targets, a bus shared with other devices is left to its owner
+         *
+         */
+        void    reset_bus() override;
     };
 
+    /** Interface to the PC8574 chip created by the LCD (empty if another transport is used) */
+    std::optional<I2CInterface> i2c;
     /** Interface to communicate with the LCD */
-    I2CInterface    con;
+    HD44780Bus      &con;
+
+    /** Layout of the rows and columns of the module in the DDRAM of the LCD */
+    Geometry        geometry;
 
     /** Location of the cursor in the DDRAM of the LCD */
     uint32_t        cursorLoc;
 
+    /** Location in the DDRAM held by the address counter of the LCD once the commands sent so far are executed */
+    uint32_t        addrCounter {0};
+    /** Whether ```addrCounter``` is known (it is not before initialization or after accessing the CGRAM) */
+    bool            addrCounterValid {false};
+    /** Whether the address counter of the LCD increments (rather than decrements) after each character */
+    bool            addrCounterInc {true};
+
     /** Bitmask containing the enabled/disabled states of the display, underline cursor and blinking cursor */
     uint16_t        displayState {0};
     /** Bitmask containing the entry mode of the LCD */
     uint16_t        cursorMovement {0};
 
+    /** Number of cells in the DDRAM of the LCD (two lines of 40 characters each, or a single line of 80) */
+    static constexpr uint32_t   DDRAM_SIZE  = 80;
+
+    /** Contents of the DDRAM of the LCD as written by the user, in the order in which the address counter visits them */
+    uint8_t         frame[DDRAM_SIZE];
+    /** Contents of the DDRAM of the LCD as last sent to it, in the same order as ```frame``` */
+    uint8_t         frameShown[DDRAM_SIZE];
+    /** Bitmask of the cells in ```frame``` that have been written to since the last flush */
+    uint8_t         frameDirty[DDRAM_SIZE / 8] {0};
+    /** Whether characters are collected in ```frame``` and only sent to the LCD by ```flush()``` */
+    bool            buffered {false};
+
+    /** Whether the initialization sequence has been run */
+    bool            initialized {false};
+    /** Whether the LCD is being resynchronized after a failed transfer (so that the recovery does not recurse) */
+    bool            recovering {false};
+
+    /** Translation applied to the characters written through the stream methods */
+    Charset         charset {Charset::RAW};
+    /** Code point shown by each location in CGRAM when it is missing from the ROM (0 if none is mapped) */
+    uint32_t        customCodepoints[8] {0};
+    /** Character shown for code points that are neither in the ROM nor mapped to the CGRAM */
+    uint8_t         replacementChar {'?'};
+    /** Bits of the UTF-8 sequence being decoded (which may be split across writes) */
+    uint32_t        utf8Codepoint {0};
+    /** Number of continuation bytes still expected by the UTF-8 sequence being decoded */
+    uint8_t         utf8Remaining {0};
+
+    /** Whether the backlight is switched on (as last requested, which may not have been sent yet in asynchronous mode) */
+    bool            backlightOn {false};
+    /** Whether the backlight was last sent lit (it is off while dimmed or asleep even if switched on) */
+    bool            backlightLit {false};
+
+    /** Number of steps in each period of the dimming for which the backlight is lit */
+    uint32_t        backlightLevel {HD44780LCD_DIMMING_LEVELS};
+    /** Step of the dimming period at which the backlight currently is */
+    uint32_t        dimmingPhase {0};
+    /** Queue on which the dimming steps run (```nullptr``` when dimming is disabled) */
+    EventQueue      *dimmingQueue {nullptr};
+    /** Time between consecutive steps of the dimming */
+    std::chrono::milliseconds   dimmingPeriod {0};
+    /** Identifier of the periodic event of the dimming on ```dimmingQueue``` (0 while asleep) */
+    int             dimmingEvent {0};
+
+    /** Whether the LCD has been put to sleep */
+    bool            asleep {false};
+    /** Whether characters were buffered before the LCD was put to sleep */
+    bool            bufferedBeforeSleep {false};
+    /** States of the display, underline cursor and blinking cursor to restore on waking up */
+    uint16_t        wakeDisplayState {0};
+
+    /** Number of commands that can be held by ```asyncQueue``` */
+    static constexpr uint32_t   ASYNC_QUEUE_SIZE    = HD44780LCD_ASYNC_QUEUE_SIZE;
+    static_assert((ASYNC_QUEUE_SIZE & (ASYNC_QUEUE_SIZE - 1)) == 0, "HD44780LCD_ASYNC_QUEUE_SIZE must be a power of 2");
+
+    /** Single-producer single-consumer ring of commands waiting to be sent to the LCD in asynchronous mode */
+    uint16_t        asyncQueue[ASYNC_QUEUE_SIZE];
+    /** Number of commands pushed into ```asyncQueue``` (only written by the producer) */
+    uint32_t        asyncHead {0};
+    /** Number of commands popped from ```asyncQueue``` (only written by the consumer) */
+    uint32_t        asyncTail {0};
+    /** Whether commands are pushed into ```asyncQueue``` instead of being sent immediately */
+    bool            asyncEnabled {false};
+    /** Whether the consumer has been notified of commands it has not started draining yet */
+    bool            asyncNotified {false};
+    /** Whether the consumer is draining ```asyncQueue``` */
+    bool            asyncBusy {false};
+    /** Event queue on which ```asyncQueue``` is drained (nullptr if a dedicated thread is used instead) */
+    EventQueue      *asyncEvents {nullptr};
+    /** Dedicated thread on which ```asyncQueue``` is drained (nullptr if an event queue is used instead) */
+    Thread          *asyncThread {nullptr};
+
+#if DEVICE_I2C_ASYNCH
+    /** Callback to invoke on completion of the transfer started by ```flush_async()``` */
+    Callback<void(int)> flushDone;
+#endif // DEVICE_I2C_ASYNCH
+
+    /** Number of batches currently open (nested batches are merged into the outermost one) */
+    uint32_t        batchDepth {0};
+    /** Whether the outermost batch should be sent in the background once it ends */
+    bool            batchAsync {false};
+
+    /** Mutex that serializes access to the LCD from multiple threads (recursive) */
+    PlatformMutex   mutex;
+
 public:
 
+    /**
+     * @brief               Guard that locks the LCD and collects all commands sent while it is alive into a batch,
+     *                      which is sent to the LCD in as few I2C transactions as possible when it is destroyed
+     *
+     * @remark              If buffering is enabled, the frame is also flushed when the guard is destroyed, such that a
+     *                      whole screen update takes a single lock and a single flush
+     *
+     * @remark              Guards can be nested, only the outermost one sends the batch
+     *
+     * @example             To update the screen from multiple threads
+     * @code
+     * {
+     *     HD44780LCD::Transaction transaction(lcd);
+     *
+     *     lcd.printf_at(0, 0, "Temp: %3d C", temp);
+     *     lcd.printf_at(1, 0, "Load: %3d%%", load);
+     * }
+     * @endcode
+     *
+     */
+    class Transaction {
+
+        /** LCD being guarded */
+        HD44780LCD  &lcd;
+
+    public:
+
+        Transaction() = delete;
+
+        Transaction(const Transaction &) = delete;
+
+        /**
+         * @brief           Lock the LCD and begin collecting commands into a batch
+         *
+         * @attention       Can not create a guard in ISR context
+         *
+         * @param lcd       LCD to guard
+         */
+        explicit Transaction(HD44780LCD &lcd);
+
+        /**
+         * @brief           Flush the frame (if buffering is enabled), send the batch and unlock the LCD
+         *
+         */
+        ~Transaction();
+    };
+
     /**
      * @brief               Different types of movements the cursor/display can perform after printing a character
      *
@@ -138,18 +765,104 @@ public:
      *
      * @param i2c_sda       Microcontroller Pin to which the SDA (Serial Data) Pin of the LCD is connected (must be an SDA Pin)
      * @param i2c_scl       Microcontroller Pin to which the SCL (Serial Clock) Pin of the LCD is connected (must be an SCL Pin)
+     * @param frequency     Frequency of the I2C bus in Hz, up to 400kHz (fast mode) is supported by the PC8574 chip,
+     *                      higher values are limited to 400kHz
+     * @param addr          8-bit address (7-bit address shifted left by 1) of the PC8574 chip on the I2C bus, such as
+     *                      ```(0x27 << 1)``` (default) or ```(0x3F << 1)``` (PC8574A)
+     * @param pinMap        Mapping of the outputs of the PC8574 chip to the pins of the LCD
+     *
+     */
+    HD44780LCD(PinName i2c_sda, PinName i2c_scl, uint32_t frequency = DEFAULT_I2C_FREQ, uint8_t addr = DEFAULT_I2C_ADDR,
+            const PinMap &pinMap = DEFAULT_PIN_MAP);
+
+    /**
+     * @brief               Construct a new HD44780LCD object for a module with a layout other than 16x2
+     *
+     * @param i2c_sda       Microcontroller Pin to which the SDA (Serial Data) Pin of the LCD is connected (must be an SDA Pin)
+     * @param i2c_scl       Microcontroller Pin to which the SCL (Serial Clock) Pin of the LCD is connected (must be an SCL Pin)
+     * @param geometry      Layout of the rows and columns of the module, such as ```HD44780LCD::GEOMETRY_20X4```
+     * @param frequency     Frequency of the I2C bus in Hz, up to 400kHz (fast mode) is supported by the PC8574 chip,
+     *                      higher values are limited to 400kHz
+     * @param addr          8-bit address (7-bit address shifted left by 1) of the PC8574 chip on the I2C bus, such as
+     *                      ```(0x27 << 1)``` (default) or ```(0x3F << 1)``` (PC8574A)
+     * @param pinMap        Mapping of the outputs of the PC8574 chip to the pins of the LCD
+     *
+     */
+    HD44780LCD(PinName i2c_sda, PinName i2c_scl, const Geometry &geometry, uint32_t frequency = DEFAULT_I2C_FREQ,
+            uint8_t addr = DEFAULT_I2C_ADDR, const PinMap &pinMap = DEFAULT_PIN_MAP);
+
+    /**
+     * @brief               Construct a new HD44780LCD object on an I2C bus shared with other devices (such as other
+     *                      LCDs at different addresses)
+     *
+     * @remark              The frequency of the bus is left as configured by its owner (up to 400kHz is supported by
+     *                      the PC8574 chip)
+     *
+     * @remark              See also ```HD44780LCDGroup``` to update multiple LCDs on the same bus in a single session
+     *
+     * @param bus           I2C bus to which the PC8574 chip is connected (must outlive the object)
+     * @param addr          8-bit address (7-bit address shifted left by 1) of the PC8574 chip on the I2C bus
+     * @param geometry      Layout of the rows and columns of the module
+     * @param pinMap        Mapping of the outputs of the PC8574 chip to the pins of the LCD
+     *
+     */
+    HD44780LCD(I2C &bus, uint8_t addr, const Geometry &geometry = GEOMETRY_16X2, const PinMap &pinMap = DEFAULT_PIN_MAP);
+
+    /**
+     * @brief               Construct a new HD44780LCD object driven through another transport (such as
+     *                      ```HD44780ParallelBus``` or ```HD44780ShiftRegisterBus```)
+     *
+     * @remark              Methods specific to the PC8574 chip (such as sending the precomputed outputs of an
+     *                      ```HD44780Screen```) fall back to the generic path on other transports
+     *
+     * @param bus           Transport connected to the LCD (must outlive the object and not be used by another LCD)
+     * @param geometry      Layout of the rows and columns of the module
+     *
+     */
+    explicit HD44780LCD(HD44780Bus &bus, const Geometry &geometry = GEOMETRY_16X2);
+
+    /**
+     * @brief               Destroy the HD44780LCD object, sending any commands that are still queued
      *
      */
-    HD44780LCD(PinName i2c_sda, PinName i2c_scl);
+    ~HD44780LCD() override;
 
     /**
      * @brief               Initializes the LCD by running its initialization sequence
      *
+     * @remark              The sequence waits for the datasheet minimum delays only, and the 40ms power-on delay is
+     *                      counted from the start of the kernel, so that it usually takes less than 10ms
+     *
+     * @remark              A warm initialization skips the power-on delay and the switch from 8-bit to 4-bit mode, and
+     *                      is only safe if the LCD has stayed powered and in 4-bit mode since it was last initialized
+     *                      (such as after a reset of the microcontroller between two instructions)
+     *
+     * @attention           Can not call this method from ISR context
+     * @attention           This method can be called from multiple threads concurrently
+     *
+     * @param warm          Whether to perform a warm initialization
+     *
+     */
+    void            initialize(bool warm = false);
+
+    /**
+     * @brief               Resynchronize the LCD with the transport and restore what it showed, by running the
+     *                      switch into 4-bit mode of the initialization sequence again, clearing the display and sending
+     *                      the contents of the DDRAM, the entry mode, the state of the display and the cursor position
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @remark              This is done automatically after a transfer fails (such as an I2C write that is not
+     *                      acknowledged even after ```HD44780LCD_I2C_RETRIES``` retries) once the command or
+     *                      transaction it belongs to has been sent, and in asynchronous mode by the consumer once it
+     *                      has drained the queue (as soon as no other thread holds the LCD)
+     * @remark              The display is returned home (undoing any display shifts), and custom characters are kept
+     *
      * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           This method can be called from multiple threads concurrently
      *
      */
-    void            initialize();
+    void            resync();
 
     // methods to display characters on the LCD
 
@@ -158,8 +871,9 @@ public:
      *
      * @remark              This method alters the cursor position
      *
-     * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
      *
      * @param byte          Character to send to be displayed
      *
@@ -171,14 +885,77 @@ public:
      *
      * @remark              This method alters the cursor position
      *
-     * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
      *
      * @param buf           Pointer to array of characters
      * @param len           Number of characters to pick from the buffer
      */
     void            send_buffer(const uint8_t *buf, const uint32_t len);
 
+    /**
+     * @brief               Format a string and display it at a position, as a single run of characters
+     *
+     * @remark              This method alters the cursor position
+     *
+     * @remark              The string is formatted into a buffer on the stack and sent by a single call to
+     *                      ```HD44780LCD::send_buffer()```, bypassing the stdio layer, and is truncated at the end of the
+     *                      row (or at the end of the line in the DDRAM, when starting past the visible columns)
+     *
+     * @remark              Control characters (such as ```'\n'```) are not interpreted, while UTF-8 input is translated
+     *                      as by the stream methods (see ```HD44780LCD::set_charset()```)
+     *
+     * @attention           Can not call this method from ISR context
+     * @attention           This method can be called from multiple threads concurrently
+     *
+     * @param r             Row at which to display the string
+     * @param c             Column at which to display the string
+     * @param fmt           Format string (as used by printf)
+     * @return int          Number of characters displayed, or a negative value if formatting failed or the position
+     *                      is outside the display
+     */
+    int             printf_at(const uint32_t r, const uint32_t c, const char *fmt, ...) MBED_PRINTF_METHOD(3, 4);
+
+    /**
+     * @brief               Format a string and display it at a position, as a single run of characters
+     *
+     * @remark              See also ```HD44780LCD::printf_at()```
+     *
+     * @attention           Can not call this method from ISR context
+     * @attention           This method can be called from multiple threads concurrently
+     *
+     * @param r             Row at which to display the string
+     * @param c             Column at which to display the string
+     * @param fmt           Format string (as used by printf)
+     * @param args          Arguments of the format string
+     * @return int          Number of characters displayed, or a negative value if formatting failed or the position
+     *                      is outside the display
+     */
+    int             vprintf_at(const uint32_t r, const uint32_t c, const char *fmt, std::va_list args)
+                    MBED_PRINTF_METHOD(3, 0);
+
+    /**
+     * @brief               Show a fixed screen, whose outputs have been encoded at compile time (see
+     *                      ```HD44780Screen```)
+     *
+     * @remark              This method alters the cursor position, the entry mode (the cursor moves right after each
+     *                      character) and the states of the display, underline cursor and blinking cursor
+     *
+     * @remark              If the screen was encoded for the layout and pin mapping of this LCD, the precomputed
+     *                      outputs are sent as they are (in a single I2C transaction), otherwise (or while asleep,
+     *                      where the screen and the state of the display are only applied on waking up) the screen is
+     *                      written cell by cell
+     *
+     * @remark              The display must not have been scrolled, the screen is shown even if buffering is enabled
+     *
+     * @attention           Can not call this method from ISR context
+     * @attention           This method can be called from multiple threads concurrently
+     *
+     * @param screen        Screen to show
+     */
+    void            show_screen(const HD44780Screen &screen);
+
     /**
      * @brief               Create a glyph for a custom character in the LCD's memory
      *                      See Example section for usage
@@ -189,7 +966,7 @@ public:
      *                      this range will cause undefined behaviour
      *
      * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           This method can be called from multiple threads concurrently
      *
      * @example             To create a smiley face and display it
      * @code
@@ -215,6 +992,280 @@ public:
      */
     void            create_custom_char(const uint32_t loc, const uint8_t glyph[8]);
 
+    /**
+     * @brief               Store consecutive custom characters (glyphs) in the CGRAM of the LCD, using a single address
+     *                      setup and a single transaction
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @remark              Glyphs that would be stored past location 7 are ignored
+     *
+     * @attention           Can not call this method from ISR context
+     * @attention           This method can be called from multiple threads concurrently
+     *
+     * @param first         Location (between 0 and 8 exclusive) in CGRAM to store the first glyph
+     * @param count         Number of glyphs to store
+     * @param glyphs        Patterns of the glyphs
+     *
+     */
+    void            load_glyphs(const uint32_t first, const uint32_t count, const uint8_t glyphs[][8]);
+
+    /**
+     * @brief               Store all eight custom characters (glyphs) in the CGRAM of the LCD at once
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @remark              See also ```HD44780LCD::load_glyphs()```
+     *
+     * @attention           Can not call this method from ISR context
+     * @attention           This method can be called from multiple threads concurrently
+     *
+     * @example             To load a font for bar graphs and display it
+     * @code
+     * static const uint8_t bars[8][8] = {
+     *             {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f},
+     *             {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x1f},
+     *             // ...
+     *             {0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f}
+     * };
+     *
+     * lcd.load_glyph_set(bars);
+     * lcd.send_buffer((const uint8_t *)"\x00\x01\x02\x03\x04\x05\x06\x07", 8);
+     * @endcode
+     *
+     * @param glyphs        Patterns of the glyphs to store at locations 0 to 7
+     *
+     */
+    void            load_glyph_set(const uint8_t glyphs[8][8]);
+
+    // methods to translate characters
+
+    /**
+     * @brief               Set the translation applied to the characters written through the stream methods (printf,
+     *                      puts, fwrite, etc.), such as decoding UTF-8 and mapping it onto the character ROM of the LCD
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @remark              The translation is done in a single pass over each block written, without any allocation,
+     *                      and sequences split across writes are decoded correctly
+     * @remark              Code points below 0x20 are sent as they are (so that custom characters can still be
+     *                      printed), ```'\n'``` and ```'\r'``` move the cursor as usual
+     * @remark              ```HD44780LCD::send_data()``` and ```HD44780LCD::send_buffer()``` always send raw bytes
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     * @example             To print a temperature on a module with the A00 ROM
+     * @code
+     * lcd.set_charset(HD44780LCD::Charset::UTF8_A00);
+     * lcd.printf("T = %d°C", temperature);
+     * @endcode
+     *
+     * @param charset       Translation to apply
+     *
+     */
+    void            set_charset(Charset charset);
+
+    /**
+     * @brief               Get the translation applied to the characters written through the stream methods
+     *
+     * @attention           This method can be called from ISR context
+     *
+     * @return Charset      Translation being applied
+     */
+    Charset         get_charset() const;
+
+    /**
+     * @brief               Show a code point that is missing from the ROM using a custom character, once its glyph has
+     *                      been stored in the CGRAM (such as by ```HD44780LCD::create_custom_char()```)
+     *
+     * @remark              Mappings take precedence over the ROM, and mapping a location again replaces its code point
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     * @example             To show the euro sign on a module with the A00 ROM
+     * @code
+     * static const uint8_t euro[8] = {0x06, 0x09, 0x1c, 0x08, 0x1c, 0x09, 0x06, 0x00};
+     *
+     * lcd.create_custom_char(0, euro);
+     * lcd.map_custom_char(0x20ac, 0);
+     * lcd.printf("%d€", price);
+     * @endcode
+     *
+     * @param codepoint     Unicode code point to show (0x20 or above)
+     * @param loc           Location (between 0 and 8 exclusive) in CGRAM of the glyph
+     * @return true         If the code point was mapped
+     * @return false        If the code point or location is invalid
+     */
+    bool            map_custom_char(uint32_t codepoint, uint32_t loc);
+
+    /**
+     * @brief               Remove all mappings of code points to custom characters
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     */
+    void            clear_custom_char_map();
+
+    /**
+     * @brief               Set the character shown for code points that are neither in the ROM nor mapped to a custom
+     *                      character (```'?'``` by default)
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     * @param code          Code of the character in the ROM (or CGRAM)
+     *
+     */
+    void            set_replacement_char(uint8_t code);
+
+    // methods to manage buffering
+
+    /**
+     * @brief               Collect characters and cursor movements in RAM instead of sending them to the LCD immediately,
+     *                      only the cells whose contents have changed are sent by ```HD44780LCD::flush()```
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @remark              While buffering is enabled, clearing the display only clears the cells in RAM, the cursor
+     *                      shown on the display only moves on flushing, and the display does not scroll after printing
+     *                      characters (regardless of the entry mode)
+     *
+     * @remark              See also ```HD44780LCD::disable_buffering()```
+     * @remark              See also ```HD44780LCD::flush()```
+     *
+     * @attention           Can not call this method from ISR context
+     * @attention           This method can be called from multiple threads concurrently
+     *
+     */
+    void            enable_buffering();
+
+    /**
+     * @brief               Flush all pending changes and resume sending characters to the LCD immediately
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @remark              See also ```HD44780LCD::enable_buffering()```
+     *
+     * @attention           Can not call this method from ISR context
+     * @attention           This method can be called from multiple threads concurrently
+     *
+     */
+    void            disable_buffering();
+
+    /**
+     * @brief               Check whether characters are being buffered in RAM
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @attention           This method can be called from ISR context
+     *
+     * @return              true if buffering is enabled, false otherwise
+     */
+    bool            is_buffering_enabled() const;
+
+    /**
+     * @brief               Send the cells that have changed since the last flush to the LCD and move the cursor shown on
+     *                      the display to the stored position
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @remark              Each run of consecutive changed cells costs a single instruction to set the address, followed
+     *                      by the characters in the run
+     *
+     * @attention           Can not call this method from ISR context
+     * @attention           This method can be called from multiple threads concurrently
+     *
+     */
+    void            flush();
+
+#if DEVICE_I2C_ASYNCH
+    /**
+     * @brief               Start sending the cells that have changed since the last flush to the LCD in the background
+     *                      (interrupt or DMA driven I2C) and return immediately
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @remark              The changes (up to ```HD44780LCD_STREAM_SIZE``` outputs) are encoded into a single I2C
+     *                      transaction, any changes beyond that are sent before this method returns
+     * @remark              Methods that access the LCD wait for the transfer to complete before doing so, and
+     *                      ```HD44780LCD::sync()``` can be used to wait for it explicitly
+     *
+     * @attention           Can not call this method from ISR context
+     * @attention           This method can be called from multiple threads concurrently
+     *
+     * @param done          Callback to invoke (from ISR context) with the I2C events (```I2C_EVENT_*```) once the transfer
+     *                      completes
+     */
+    void            flush_async(Callback<void(int)> done = nullptr);
+#endif // DEVICE_I2C_ASYNCH
+
+    // methods to manage asynchronous mode
+
+    /**
+     * @brief               Push commands into a lock-free queue instead of sending them to the LCD from the calling thread,
+     *                      the queue is drained on the given event queue, or on a dedicated thread if none is given
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @remark              While asynchronous mode is enabled, methods that send characters or instructions only update
+     *                      the state in RAM and push commands into the queue, and the ones documented as such can be
+     *                      called from ISR context
+     * @remark              The queue takes commands from exactly one producer context, either threads (which are
+     *                      serialized by the lock) or a single ISR, but never both, since the lock is not taken in ISR
+     *                      context
+     * @remark              In ISR context, commands that do not fit in the queue are dropped without any notice (only
+     *                      the tracked address counter is invalidated), so ```HD44780LCD_ASYNC_QUEUE_SIZE``` must hold
+     *                      the bursts pushed from the ISR, in thread context the caller waits for space in the queue
+     *                      instead
+     * @remark              Methods that read from the LCD (and ```HD44780LCD::initialize()```) wait for the queue to be
+     *                      drained before running
+     *
+     * @remark              See also ```HD44780LCD::disable_async()```
+     * @remark              See also ```HD44780LCD::sync()```
+     *
+     * @attention           Can not call this method from ISR context
+     * @attention           This method can be called from multiple threads concurrently
+     *
+     * @param queue         Event queue to drain the queue on (must be dispatched from a thread), or nullptr to start a
+     *                      dedicated thread
+     */
+    void            enable_async(EventQueue *queue = nullptr);
+
+    /**
+     * @brief               Wait for all queued commands to be sent and resume sending commands from the calling thread
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @remark              See also ```HD44780LCD::enable_async()```
+     *
+     * @attention           Can not call this method from ISR context
+     * @attention           This method can be called from multiple threads concurrently
+     *
+     */
+    void            disable_async();
+
+    /**
+     * @brief               Check whether asynchronous mode is enabled
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @attention           This method can be called from ISR context
+     *
+     * @return              true if asynchronous mode is enabled, false otherwise
+     */
+    bool            is_async_enabled() const;
+
+    /**
+     * @brief               Wait for all queued commands and any transfer started by ```HD44780LCD::flush_async()``` to be
+     *                      sent to the LCD
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @attention           Can not call this method from ISR context
+     * @attention           This method can be called from multiple threads concurrently
+     *
+     */
+    void            sync();
+
     // method to manage backlight
 
     /**
@@ -223,7 +1274,7 @@ public:
      * @remark              This method does not alter the cursor position
      *
      * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           This method can be called from multiple threads concurrently
      *
      */
     void            enable_backlight();
@@ -234,7 +1285,7 @@ public:
      * @remark              This method does not alter the cursor position
      *
      * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           This method can be called from multiple threads concurrently
      *
      */
     void            disable_backlight();
@@ -245,21 +1296,210 @@ public:
      * @remark              This method does not alter the cursor position
      *
      * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           This method can be called from multiple threads concurrently
+     *
+     */
+    void            toggle_backlight();
+
+    /**
+     * @brief               Check the state of the LCD's backlight
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @attention           This method can be called from ISR context
+     *
+     * @return              true if the backlight is switched on, false otherwise
+     */
+    bool            is_backlight_on() const;
+
+    /**
+     * @brief               Start dimming the backlight by switching it periodically (as a PWM at the speed of the
+     *                      I2C bus), with each switch only writing the backlight output of the PC8574 chip
+     *
+     * @remark              The backlight is switched every ```period```, and a whole dimming period consists of
+     *                      ```HD44780LCD_DIMMING_LEVELS``` such steps, the backlight is only written when it changes (so
+     *                      there is no bus traffic at the lowest and highest levels)
+     *
+     * @remark              Steps that find the LCD locked by another thread are skipped, and switches are queued after
+     *                      the pending commands in asynchronous mode
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     * @param queue         Queue on which the steps run (must outlive the LCD or dimming must be disabled first)
+     * @param period        Time between consecutive steps
+     * @return true         If the dimming was started
+     * @return false        If it is already running or the queue is full
+     */
+    bool            enable_dimming(EventQueue &queue, std::chrono::milliseconds period = DIMMING_PERIOD);
+
+    /**
+     * @brief               Stop dimming the backlight, leaving it completely lit (if switched on)
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     */
+    void            disable_dimming();
+
+    /**
+     * @brief               Set the brightness of the backlight while dimming is enabled
+     *
+     * @attention           This method can be called from ISR context
+     *
+     * @param level         Number of steps of each dimming period for which the backlight is lit (from 0 to
+     *                      ```HD44780LCD_DIMMING_LEVELS```)
+     */
+    void            set_backlight_level(uint32_t level);
+
+    /**
+     * @brief               Get the brightness of the backlight while dimming is enabled
+     *
+     * @attention           This method can be called from ISR context
+     *
+     * @return uint32_t     Number of steps of each dimming period for which the backlight is lit
+     */
+    uint32_t        get_backlight_level() const;
+
+    // methods to save power
+
+    /**
+     * @brief               Put the LCD to sleep, switching the display and backlight off while it keeps the contents of
+     *                      its DDRAM and CGRAM, and stopping all periodic bus traffic
+     *
+     * @remark              While asleep, characters are only collected in the frame (as with buffering), changes to the
+     *                      states of the display and backlight are recorded to be applied on waking up, the dimming is
+     *                      paused, and the timer of the interface is stopped so that it does not keep the
+     *                      microcontroller out of deep sleep
+     *
+     * @remark              Other methods that send instructions (such as moving the cursor or creating custom
+     *                      characters) still talk to the LCD
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     */
+    void            sleep();
+
+    /**
+     * @brief               Wake the LCD up, sending the characters written while asleep (unless buffering was enabled
+     *                      before) and restoring the states of the display and backlight, without initializing it again
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     */
+    void            wake();
+
+    /**
+     * @brief               Check whether the LCD has been put to sleep
+     *
+     * @attention           This method can be called from ISR context
+     *
+     * @return true         If the LCD is asleep
+     * @return false        Otherwise
+     */
+    bool            is_asleep() const;
+
+#if HD44780LCD_ENABLE_STATS
+    // methods to instrument the LCD
+
+    /**
+     * @brief               Get the counters of the instructions, data bytes and bus writes sent to the LCD and of the
+     *                      time spent blocked in sending them, since construction or the last call to
+     *                      ```HD44780LCD::reset_stats()```
+     *
+     * @remark              Only available when ```HD44780LCD_ENABLE_STATS``` is defined to 1, otherwise the transports
+     *                      do not keep any counters
+     * @remark              Instructions and data bytes collected while batching are counted when they are collected,
+     *                      and the time spent blocked when the batch is sent
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     * @return Stats        Copy of the counters
+     */
+    Stats           get_stats();
+
+    /**
+     * @brief               Reset all counters returned by ```HD44780LCD::get_stats()``` to zero
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     */
+    void            reset_stats();
+#endif // HD44780LCD_ENABLE_STATS
+
+    // methods to read back from the LCD
+
+    /**
+     * @brief               Poll the busy flag of the LCD (instead of waiting for the datasheet execution time) before
+     *                      sending it instructions that take long to execute, such as clearing the display
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @remark              Requires the RW pin of the LCD to be connected to the PC8574 chip (or to the transport in
+     *                      use), if it is tied to ground the busy flag always reads as set and waits take twice as long
+     *                      as the execution time, transports that can not read back (such as a shift register) ignore
+     *                      this method
+     * @remark              Reading the busy flag takes several I2C transactions, which is longer than most
+     *                      instructions take to execute, so only the clear display and home instructions are polled
+     *
+     * @remark              See also ```HD44780LCD::disable_busy_polling()```
+     *
+     * @attention           Can not call this method from ISR context
+     * @attention           This method can be called from multiple threads concurrently
+     *
+     */
+    void            enable_busy_polling();
+
+    /**
+     * @brief               Wait for the datasheet execution time of instructions instead of polling the busy flag
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @remark              See also ```HD44780LCD::enable_busy_polling()```
+     *
+     * @attention           Can not call this method from ISR context
+     * @attention           This method can be called from multiple threads concurrently
+     *
+     */
+    void            disable_busy_polling();
+
+    /**
+     * @brief               Check whether the busy flag of the LCD is polled
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @attention           This method can be called from ISR context
+     *
+     * @return              true if the busy flag is polled, false otherwise
+     */
+    bool            is_busy_polling_enabled() const;
+
+    /**
+     * @brief               Read the address counter of the LCD (location of the cursor in the DDRAM as seen by the LCD)
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @remark              Requires the RW pin of the LCD to be connected to the PC8574 chip (or to the transport in use)
+     *
+     * @attention           Can not call this method from ISR context
+     * @attention           This method can be called from multiple threads concurrently
      *
+     * @return uint32_t     Value of the address counter (0 if the transport can not read from the LCD, or if the read
+     *                      failed, in which case the LCD is resynchronized)
      */
-    void            toggle_backlight();
+    uint32_t        read_address_counter();
 
     /**
-     * @brief               Check the state of the LCD's backlight
+     * @brief               Check whether the stored position of the cursor matches the address counter of the LCD
      *
      * @remark              This method does not alter the cursor position
      *
-     * @attention           This method can be called from ISR context
+     * @remark              Requires the RW pin of the LCD to be connected to the PC8574 chip
      *
-     * @return              true if the backlight is switched on, false otherwise
+     * @attention           Can not call this method from ISR context
+     * @attention           This method can be called from multiple threads concurrently
+     *
+     * @return              true if the positions match, false otherwise
      */
-    bool            is_backlight_on() const;
+    bool            is_cursor_pos_synced();
 
     // methods to manage entry mode
 
@@ -268,8 +1508,9 @@ public:
      *
      * @remark              This method does not alter the cursor position
      *
-     * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
      *
      */
     void            set_cursor_auto_dec();
@@ -279,8 +1520,9 @@ public:
      *
      * @remark              This method does not alter the cursor position
      *
-     * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
      *
      */
     void            set_cursor_auto_inc();
@@ -290,8 +1532,9 @@ public:
      *
      * @remark              This method does not alter the cursor position
      *
-     * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
      *
      * @warning             Setters/Getters for cursor position do not work in a well-defined way after calling this method
      *
@@ -303,8 +1546,9 @@ public:
      *
      * @remark              This method does not alter the cursor position
      *
-     * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
      *
      * @warning             Setters/Getters for cursor position do not work in a well-defined way after calling this method
      *
@@ -332,10 +1576,11 @@ public:
     /**
      * @brief               Clear the display
      *
-     * @remark              This method does not alter the cursor position
+     * @remark              The cursor is returned home (to the first column of the first row), as done by the LCD
      *
-     * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
      *
      */
     void            clear_display();
@@ -348,8 +1593,9 @@ public:
      * @remark              See also ```HD44780LCD::disable_display()```
      * @remark              See also ```HD44780LCD::toggle_display()```
      *
-     * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
      *
      */
     void            enable_display();
@@ -362,8 +1608,9 @@ public:
      * @remark              See also ```HD44780LCD::enable_display()```
      * @remark              See also ```HD44780LCD::toggle_display()```
      *
-     * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
      *
      */
     void            disable_display();
@@ -376,8 +1623,9 @@ public:
      * @remark              See also ```HD44780LCD::enable_display()```
      * @remark              See also ```HD44780LCD::disable_display()```
      *
-     * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
      *
      */
     void            toggle_display();
@@ -393,12 +1641,35 @@ public:
      */
     bool            is_display_enabled() const;
 
+    /**
+     * @brief               Set whether the display, the underline cursor and the blinking cursor are enabled at once,
+     *                      using a single instruction
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @remark              No instruction is sent if the states are already as requested
+     *
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
+     *
+     * @param display       Whether the display should be enabled
+     * @param cursor        Whether the underline cursor should be displayed
+     * @param blink         Whether the blinking cursor should be displayed
+     */
+    void            set_display_control(bool display, bool cursor, bool blink);
+
     // methods to manage cursor position
 
     /**
      * @brief               Set the cursor to the home position
      *
      * @remark              This method alters the cursor position
+     *
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
+     *
      */
     void            set_cursor_home();
 
@@ -407,8 +1678,9 @@ public:
      *
      * @remark              This method alters the cursor position
      *
-     * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
      *
      */
     void            move_cursor_left();
@@ -418,8 +1690,9 @@ public:
      *
      * @remark              This method alters the cursor position
      *
-     * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
      *
      */
     void            move_cursor_right();
@@ -429,11 +1702,13 @@ public:
      *
      * @remark              This method alters the cursor position
      *
-     * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
      *
      * @param r             Row to which the cursor should be moved
-     * @param c             Column to which the cursor should be moved
+     * @param c             Column to which the cursor should be moved (may be past the visible columns, up to the end
+     *                      of the line in the DDRAM)
      */
     void            set_cursor_pos(const uint32_t r, const uint32_t c);
 
@@ -459,6 +1734,57 @@ public:
      */
     uint32_t        get_cursor_col() const;
 
+    /**
+     * @brief               Get the character at a position on the display, as last written to it (including characters
+     *                      that have not been flushed yet in buffered mode)
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @attention           This method can be called from ISR context
+     *
+     * @param r             Row of the character
+     * @param c             Column of the character
+     * @return uint8_t      Character at the position (a space for positions outside the display)
+     */
+    uint8_t         get_char_at(const uint32_t r, const uint32_t c) const;
+
+    /**
+     * @brief               Get the number of rows on the module
+     *
+     * @attention           This method can be called from ISR context
+     *
+     * @return uint32_t     Number of rows
+     */
+    uint32_t        get_row_count() const;
+
+    /**
+     * @brief               Get the number of visible columns on the module
+     *
+     * @attention           This method can be called from ISR context
+     *
+     * @return uint32_t     Number of columns
+     */
+    uint32_t        get_col_count() const;
+
+    /**
+     * @brief               Get the number of cells in each line of the DDRAM, including those past the visible columns
+     *                      (40 in two-line mode, 80 in single-line mode)
+     *
+     * @attention           This method can be called from ISR context
+     *
+     * @return uint32_t     Number of cells in a line
+     */
+    uint32_t        get_line_size() const;
+
+    /**
+     * @brief               Get the layout of the rows and columns of the module
+     *
+     * @attention           This method can be called from ISR context
+     *
+     * @return const Geometry& Layout of the module
+     */
+    const Geometry &get_geometry() const;
+
     // methods to manage cursor aesthetic
 
     /**
@@ -469,8 +1795,9 @@ public:
      * @remark              See also ```HD44780LCD::disable_cursor_display()```
      * @remark              See also ```HD44780LCD::toggle_cursor_display()```
      *
-     * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
      *
      */
     void            enable_cursor_display();
@@ -483,8 +1810,9 @@ public:
      * @remark              See also ```HD44780LCD::enable_cursor_display()```
      * @remark              See also ```HD44780LCD::toggle_cursor_display()```
      *
-     * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
      *
      */
     void            disable_cursor_display();
@@ -497,8 +1825,9 @@ public:
      * @remark              See also ```HD44780LCD::enable_cursor_display()```
      * @remark              See also ```HD44780LCD::disable_cursor_display()```
      *
-     * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
      *
      */
     void            toggle_cursor_display();
@@ -522,8 +1851,9 @@ public:
      * @remark              See also ```HD44780LCD::disable_blinking_display()```
      * @remark              See also ```HD44780LCD::toggle_blinking_display()```
      *
-     * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
      *
      */
     void            enable_blinking_cursor();
@@ -536,8 +1866,9 @@ public:
      * @remark              See also ```HD44780LCD::enable_blinking_display()```
      * @remark              See also ```HD44780LCD::toggle_blinking_display()```
      *
-     * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
      *
      */
     void            disable_blinking_cursor();
@@ -550,8 +1881,9 @@ public:
      * @remark              See also ```HD44780LCD::enable_blinking_display()```
      * @remark              See also ```HD44780LCD::disable_blinking_display()```
      *
-     * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
      *
      */
     void            toggle_blinking_cursor();
@@ -575,8 +1907,9 @@ public:
      * @warning             This method scrolls the display contents to the left without moving the cursor's location,
      *                      but the position changes as the cursor is also moved to the left
      *
-     * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
      *
      */
     void            scroll_display_left();
@@ -587,8 +1920,9 @@ public:
      * @warning             This method scrolls the display contents to the right without moving the cursor's location,
      *                      but the position changes as the cursor is also moved to the right
      *
-     * @attention           Can not call this method from ISR context
-     * @attention           It is unsafe to call this method from multiple threads concurently
+     * @attention           Can not call this method from ISR context, unless asynchronous mode is enabled (see
+     *                      ```HD44780LCD::enable_async()```)
+     * @attention           This method can be called from multiple threads concurrently
      *
      */
     void            scroll_display_right();
@@ -596,11 +1930,12 @@ public:
     // methods for getting stream
 
     /**
-     * @brief               Get a pointer to the underlying stream for using with file stream APIs
+     * @brief               Get a pointer to the underlying stream for using with file stream APIs, initializing the LCD
+     *                      if it has not been initialized yet
      *
      * @remark              This method does not alter the cursor position
      *
-     * @attention           It is safe to call this method from ISR context
+     * @attention           It is safe to call this method from ISR context once the LCD has been initialized
      *
      * @return HD44780LCD*  Pointer to underlying stream
      */
@@ -611,15 +1946,287 @@ public:
     int             _putc(int c) override;
     int             _getc() override;
 
+    /**
+     * @brief               Write a block of characters to the LCD (used by printf, puts, fwrite, etc.)
+     *
+     * @remark              This method alters the cursor position
+     *
+     * @remark              ```'\n'``` and ```'\r'``` are handled as by ```HD44780LCD::_putc()```, while the runs of
+     *                      characters between them are sent by single calls to ```HD44780LCD::send_buffer()```, all
+     *                      collected into as few I2C transactions as possible
+     *
+     * @attention           Can not call this method from ISR context
+     * @attention           This method can be called from multiple threads concurrently
+     *
+     * @param buffer        Characters to write
+     * @param length        Number of characters to write
+     * @return ssize_t      Number of characters written
+     */
+    ssize_t         write(const void *buffer, size_t length) override;
+
+    /**
+     * @brief               Lock the built-in mutex of the LCD (recursive, such that it can be locked again by the same
+     *                      thread)
+     *
+     * @attention           Has no effect in ISR context, where only the asynchronous mode can be used safely
+     *
+     */
+    void            lock() override;
+
+    /**
+     * @brief               Unlock the built-in mutex of the LCD
+     *
+     * @attention           Has no effect in ISR context
+     *
+     */
+    void            unlock() override;
+
 private:
 
     /**
-     * @brief               Update the position of the cursor in the display to match the stored value
+     * @brief               Lock the LCD and begin collecting commands into a batch, as part of a session of
+     *                      ```HD44780LCDGroup```
+     *
+     */
+    void            begin_session();
+
+    /**
+     * @brief               Send the changes to the frame (if buffering is enabled) into the batch of the session
+     *
+     * @return true         If the batch has outputs waiting to be written in the shared bus session
+     * @return false        If the batch is empty, or is sent by other means (in asynchronous mode, or by an enclosing
+     *                      batch)
+     */
+    bool            prepare_session();
+
+    /**
+     * @brief               End the batch of the session and unlock the LCD
+     *
+     * @param repeated      Whether to end the transaction with a repeated start so that the next LCD follows immediately
+     */
+    void            end_session(bool repeated);
+
+    /**
+     * @brief               Move the cursor to the same column of the next row (wrapping around to the first row)
+     *
+     */
+    void            new_line();
+
+    /**
+     * @brief               Move the cursor to the first column of its row
+     *
+     */
+    void            carriage_return();
+
+    /**
+     * @brief               Update the position of the cursor in the display to match the stored value, if the address
+     *                      counter of the LCD is not already there
      *
      * @attention           Can not call this method from ISR context
      */
     void            update_display_cursor_pos();
 
+    /**
+     * @brief               Update the position of the cursor in the display if the cursor is visible, otherwise leave
+     *                      it to be updated before the next character is sent
+     *
+     * @attention           Can not call this method from ISR context
+     */
+    void            request_cursor_pos_update();
+
+    /**
+     * @brief               Move the address counter of the LCD to a location in the DDRAM, unless it is already there
+     *
+     * @param loc           Location in the DDRAM
+     */
+    void            set_address_counter(uint32_t loc);
+
+    /**
+     * @brief               Store the state of the display, cursor and blink, sending the display control instruction only
+     *                      if it differs from the stored one
+     *
+     * @param state         Bitmask containing the enabled/disabled states of the display, cursor and blink
+     */
+    void            write_display_control(uint16_t state);
+
+    /**
+     * @brief               Store the entry mode, sending the entry mode instruction only if it differs from the stored one
+     *
+     * @param movement      Bitmask containing the entry mode
+     */
+    void            write_entry_mode(uint16_t movement);
+
+    /**
+     * @brief               Feed a byte of UTF-8 input into the decoder
+     *
+     * @remark              Invalid bytes decode to U+FFFD, and a sequence cut short by another lead byte is dropped
+     *
+     * @param byte          Byte of input
+     * @param codepoint     Decoded code point, set when a sequence is complete
+     * @return true         If a code point has been decoded
+     * @return false        If more bytes are needed
+     */
+    bool            decode_utf8(uint8_t byte, uint32_t &codepoint);
+
+    /**
+     * @brief               Get the code of the character that shows a code point using the selected character set
+     *
+     * @param codepoint     Unicode code point
+     * @return uint8_t      Code of the character in the ROM or CGRAM (```replacementChar``` if there is none)
+     */
+    uint8_t         translate(uint32_t codepoint) const;
+
+    /**
+     * @brief               Decode and translate a complete string in place (when a UTF-8 character set is selected), as
+     *                      done by ```HD44780LCD::printf_at()```
+     *
+     * @param buf           Characters to translate (replaced by the translated ones)
+     * @param len           Number of bytes in the string
+     * @return uint32_t     Number of translated characters
+     */
+    uint32_t        translate_in_place(char *buf, uint32_t len);
+
+    /**
+     * @brief               Write a block of characters, decoding and translating it (when a UTF-8 character set is
+     *                      selected)
+     *
+     * @param buf           Characters to write
+     * @param length        Number of bytes to write
+     */
+    void            write_translated(const uint8_t *buf, size_t length);
+
+    /**
+     * @brief               Switch the LCD into the mode (4-bit or 8-bit) of the transport regardless of the mode it is
+     *                      in, using the function sets of the initialization sequence
+     *
+     */
+    void            send_resync_sequence();
+
+    /**
+     * @brief               Reset the bus, resynchronize the LCD and restore what it showed (see ```resync()```)
+     *
+     * @remark              Everything is sent through the transport directly, never through the asynchronous queue,
+     *                      so that the consumer can recover without becoming a producer
+     *
+     */
+    void            recover();
+
+    /**
+     * @brief               Recover from a failed transfer, if one has occurred and the commands are sent synchronously
+     *                      outside of a batch
+     *
+     */
+    void            check_fault();
+
+    /**
+     * @brief               Send an instruction to the LCD (or queue it in asynchronous mode)
+     *
+     * @param instr         Instruction to send
+     * @param execTime      Time the LCD takes to execute the instruction
+     */
+    void            write_instruction(uint8_t instr, std::chrono::microseconds execTime = EXEC_TIME);
+
+    /**
+     * @brief               Send an array of data bytes to the LCD (or queue them in asynchronous mode)
+     *
+     * @param buf           Pointer to array of bytes
+     * @param len           Number of bytes to pick from the buffer
+     */
+    void            write_data(const uint8_t *buf, uint32_t len);
+
+    /**
+     * @brief               Switch the backlight of the LCD on or off (or queue it in asynchronous mode)
+     *
+     * @param on            Whether the backlight should be switched on
+     */
+    void            write_backlight(bool on);
+
+    /**
+     * @brief               Check whether the backlight should be lit at this time (switched on, not asleep, and within
+     *                      the lit part of the dimming period)
+     *
+     * @return true         If the backlight should be lit
+     * @return false        Otherwise
+     */
+    bool            is_backlight_lit() const;
+
+    /**
+     * @brief               Send the state of the backlight to the LCD (queued in asynchronous mode)
+     *
+     * @param lit           Whether the backlight is lit
+     */
+    void            send_backlight(bool lit);
+
+    /**
+     * @brief               Advance the dimming by a step and switch the backlight if needed (runs on the queue of the
+     *                      dimming)
+     *
+     */
+    void            dimming_step();
+
+    /**
+     * @brief               Start or stop collecting the subsequent commands into a single transaction (or queue it in
+     *                      asynchronous mode)
+     *
+     * @param marker        Whether to begin the batch, end it, or end it with an asynchronous transfer
+     */
+    void            write_batch(uint8_t marker);
+
+    /**
+     * @brief               Send (or queue) the instructions and characters that update the cells that have changed since
+     *                      the last flush, followed by the position of the cursor
+     *
+     */
+    void            write_frame_changes();
+
+    /**
+     * @brief               Push a command into the asynchronous queue, waiting for space (or discarding the command in ISR
+     *                      context) if it is full
+     *
+     * @param command       Command to push
+     */
+    void            push_async(uint16_t command);
+
+    /**
+     * @brief               Notify the consumer that commands have been pushed into the asynchronous queue
+     *
+     */
+    void            notify_async();
+
+    /**
+     * @brief               Send all commands in the asynchronous queue to the LCD and recover from any transfer that
+     *                      failed meanwhile (runs on the consumer)
+     *
+     */
+    void            drain_async();
+
+    /**
+     * @brief               Send the commands in the asynchronous queue to the LCD until it is empty (runs on the
+     *                      consumer)
+     *
+     */
+    void            send_queued();
+
+    /**
+     * @brief               Entry point of the dedicated thread that drains the asynchronous queue
+     *
+     */
+    void            async_thread_main();
+
+    /**
+     * @brief               Update ```addrCounter``` to reflect the effect of an instruction on the address counter
+     *
+     * @param instr         Instruction being sent
+     */
+    void            track_instruction(uint8_t instr);
+
+    /**
+     * @brief               Update ```addrCounter``` to reflect the effect of writing characters on the address counter
+     *
+     * @param len           Number of characters being written
+     */
+    void            track_data(uint32_t len);
+
     /**
      * @brief               Increment the position of the cursor while handling wrap-around
      *
@@ -631,6 +2238,88 @@ private:
      *
      */
     void            dec_cursor_loc();
+
+    /**
+     * @brief               Move the position of the cursor in the direction set by the entry mode
+     *
+     */
+    void            advance_cursor_loc();
+
+    /**
+     * @brief               Check whether a position can be moved to by ```set_cursor_pos()```
+     *
+     * @param r             Row of the position
+     * @param c             Column of the position
+     * @return true         If the row exists and the column lies within the line of the row in the DDRAM
+     * @return false        Otherwise
+     */
+    bool            is_valid_pos(uint32_t r, uint32_t c) const;
+
+    /**
+     * @brief               Get the location the address counter moves to when incremented from a location, wrapping
+     *                      around in the same way as the LCD
+     *
+     * @param loc           Location in the DDRAM
+     * @return uint32_t     Next location in the DDRAM
+     */
+    uint32_t        next_loc(uint32_t loc) const;
+
+    /**
+     * @brief               Get the location the address counter moves to when decremented from a location, wrapping
+     *                      around in the same way as the LCD
+     *
+     * @param loc           Location in the DDRAM
+     * @return uint32_t     Previous location in the DDRAM
+     */
+    uint32_t        prev_loc(uint32_t loc) const;
+
+    /**
+     * @brief               Get the location in the DDRAM at which the line containing a location starts
+     *
+     * @param loc           Location in the DDRAM
+     * @return uint32_t     Location of the first character of the line
+     */
+    uint32_t        line_start(uint32_t loc) const;
+
+    /**
+     * @brief               Get the number of characters in each line of the DDRAM (40 in 2-line mode, 80 otherwise)
+     *
+     * @return uint32_t     Number of characters in each line
+     */
+    uint32_t        line_size() const;
+
+    /**
+     * @brief               Get the index in ```frame``` of a location in the DDRAM
+     *
+     * @param loc           Location in the DDRAM
+     * @return uint32_t     Index of the cell in ```frame```
+     */
+    uint32_t        frame_index(uint32_t loc) const;
+
+    /**
+     * @brief               Get the location in the DDRAM of an index in ```frame```
+     *
+     * @param idx           Index of the cell in ```frame```
+     * @return uint32_t     Location in the DDRAM
+     */
+    uint32_t        frame_loc(uint32_t idx) const;
+
+    /**
+     * @brief               Store a character in the cell at the current position of the cursor
+     *
+     * @param byte          Character to store
+     * @param sent          Whether the character has already been sent to the LCD (otherwise the cell is marked to be
+     *                      compared and sent by ```flush()```)
+     */
+    void            store_cell(uint8_t byte, bool sent);
+
+    /**
+     * @brief               Reset all cells to blank (space characters), as done by the LCD on clearing the display
+     *
+     * @param sent          Whether the LCD has already been cleared (otherwise the cells are marked to be compared and
+     *                      sent by ```flush()```)
+     */
+    void            clear_frame(bool sent);
 };
 
 #endif //__HD44780LCD_H__
@@ -0,0 +1,81 @@
+/**
+ * @file                    HD44780LCDGroup.cpp
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Group of HD44780 LCDs sharing an I2C bus, updated together in a single bus session
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#include "HD44780LCDGroup.h"
+
+// Constructors
+
+HD44780LCDGroup::HD44780LCDGroup(I2C &bus)
+        : bus {bus}
+{
+}
+
+// public methods
+
+bool
+HD44780LCDGroup::add(HD44780LCD &lcd) {
+
+    if (active || count == HD44780LCD_GROUP_SIZE) {
+        return false;
+    }
+
+    lcds[count++] = &lcd;
+    return true;
+}
+
+void
+HD44780LCDGroup::begin() {
+
+    if (active) {
+        return;
+    }
+
+    // the LCDs are always locked in the same order, so that two groups sharing LCDs can not deadlock
+    for (uint32_t i = 0; i < count; ++i) {
+        lcds[i]->begin_session();
+    }
+
+    active = true;
+}
+
+void
+HD44780LCDGroup::commit() {
+
+    if (!active) {
+        return;
+    }
+
+    bool pending[HD44780LCD_GROUP_SIZE];
+    int32_t last = -1;
+
+    for (uint32_t i = 0; i < count; ++i) {
+
+        pending[i] = lcds[i]->prepare_session();
+        if (pending[i]) {
+            last = i;
+        }
+    }
+
+    // every write but the last one ends with a repeated start, so that the bus is not released in between
+    bus.lock();
+
+    for (uint32_t i = 0; i < count; ++i) {
+        lcds[i]->end_session(pending[i] && ((int32_t)i != last));
+    }
+
+    bus.unlock();
+
+    active = false;
+}
+
+bool
+HD44780LCDGroup::is_active() const {
+    return active;
+}
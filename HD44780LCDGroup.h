@@ -0,0 +1,117 @@
+/**
+ * @file                    HD44780LCDGroup.h
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Group of HD44780 LCDs sharing an I2C bus, updated together in a single bus session
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#ifndef __HD44780LCDGROUP_H__
+#define __HD44780LCDGROUP_H__
+
+#include "HD44780LCD.h"
+
+#ifndef HD44780LCD_GROUP_SIZE
+/** Maximum number of LCDs in a group (the PC8574 and PC8574A chips have 8 addresses each) */
+#define HD44780LCD_GROUP_SIZE           8
+#endif
+
+/**
+ * @brief                   Class that updates multiple LCDs on the same I2C bus together, by collecting the commands
+ *                          sent to each of them and writing them back-to-back (joined by repeated starts) while the bus
+ *                          is locked once
+ *
+ * @remark                  LCDs in asynchronous mode are locked and batched with the rest of the group, but their
+ *                          batches are sent by their own consumers once the session ends
+ *
+ * @example                 To update four status panels on one bus
+ * @code
+ * I2C bus(I2C_SDA, I2C_SCL);
+ *
+ * HD44780LCD panels[4] = {
+ *     {bus, (0x27 << 1)}, {bus, (0x26 << 1)}, {bus, (0x25 << 1)}, {bus, (0x24 << 1)}
+ * };
+ *
+ * HD44780LCDGroup group(bus);
+ * for (auto &panel : panels) {
+ *     group.add(panel);
+ * }
+ *
+ * group.begin();
+ * for (uint32_t i = 0; i < 4; ++i) {
+ *     panels[i].printf_at(0, 0, "Panel %lu: %3d", i, values[i]);
+ * }
+ * group.commit();
+ * @endcode
+ *
+ */
+class HD44780LCDGroup {
+
+    /** I2C bus shared by the LCDs */
+    I2C             &bus;
+
+    /** LCDs in the group */
+    HD44780LCD      *lcds[HD44780LCD_GROUP_SIZE];
+    /** Number of LCDs in the group */
+    uint32_t        count {0};
+    /** Whether a session has been begun and not committed yet */
+    bool            active {false};
+
+public:
+
+    HD44780LCDGroup() = delete;
+
+    HD44780LCDGroup(const HD44780LCDGroup &) = delete;
+
+    /**
+     * @brief               Construct a new HD44780LCDGroup object
+     *
+     * @param bus           I2C bus shared by the LCDs of the group
+     *
+     */
+    explicit HD44780LCDGroup(I2C &bus);
+
+    /**
+     * @brief               Add an LCD to the group
+     *
+     * @attention           Can not call this method while a session is active
+     *
+     * @param lcd           LCD to add (must have been constructed on the bus of the group)
+     * @return true         If the LCD was added
+     * @return false        If the group is full or a session is active
+     */
+    bool            add(HD44780LCD &lcd);
+
+    /**
+     * @brief               Begin a session, locking all LCDs of the group and collecting the commands subsequently sent
+     *                      to each of them
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     */
+    void            begin();
+
+    /**
+     * @brief               End the session, flushing the frames of the LCDs (if buffering is enabled on them), writing
+     *                      the collected commands of all LCDs back-to-back while the bus is locked and unlocking the
+     *                      LCDs
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     */
+    void            commit();
+
+    /**
+     * @brief               Check whether a session is active
+     *
+     * @attention           This method can be called from ISR context
+     *
+     * @return true         If a session has been begun and not committed yet
+     * @return false        Otherwise
+     */
+    bool            is_active() const;
+};
+
+#endif //__HD44780LCDGROUP_H__
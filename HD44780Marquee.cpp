@@ -0,0 +1,169 @@
+/**
+ * @file                    HD44780Marquee.cpp
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Scrolling marquee for HD44780 LCDs, moved by the display shift instruction of the LCD
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#include "HD44780Marquee.h"
+
+// Constructors
+
+HD44780Marquee::HD44780Marquee(HD44780LCD &lcd, uint32_t gap)
+        : lcd {lcd}
+        , gap {gap}
+{
+}
+
+HD44780Marquee::~HD44780Marquee() {
+    stop();
+}
+
+// public methods
+
+void
+HD44780Marquee::set_text(uint32_t r, const char *text) {
+
+    if (r >= MAX_ROWS || r >= lcd.get_row_count()) {
+        return;
+    }
+
+    // a step may be running on the queue at the same time
+    lcd.lock();
+
+    const uint32_t lineSize = lcd.get_line_size();
+
+    texts[r] = text;
+    lengths[r] = (text != nullptr) ? strlen(text) : 0;
+
+    // text that fits in a line is padded to fill it, so that the line holds its contents for every step
+    periods[r] = ((lengths[r] + gap) > lineSize) ? (lengths[r] + gap) : lineSize;
+
+    loaded = false;
+
+    lcd.unlock();
+}
+
+void
+HD44780Marquee::step() {
+
+    if (!is_supported()) {
+        return;
+    }
+
+    HD44780LCD::Transaction transaction(lcd);
+
+    if (!loaded) {
+
+        load();
+        return;
+    }
+
+    const uint32_t lineSize = lcd.get_line_size();
+    const uint32_t rows = lcd.get_row_count();
+
+    lcd.scroll_display_left();
+
+    // the cell that just scrolled out on the left is the last one to scroll in on the right, so the character that
+    // follows the line is written to it (unless it already holds the same one)
+    for (uint32_t r = 0; r < rows; ++r) {
+
+        auto leaving = positions[r];
+        auto entering = (positions[r] + lineSize) % periods[r];
+
+        if (char_at(r, leaving) != char_at(r, entering)) {
+
+            lcd.set_cursor_pos(r, shift);
+            lcd.send_data(char_at(r, entering));
+        }
+
+        positions[r] = (positions[r] + 1) % periods[r];
+    }
+
+    shift = (shift + 1) % lineSize;
+}
+
+bool
+HD44780Marquee::start(EventQueue &queue, std::chrono::milliseconds period) {
+
+    if (this->queue != nullptr || !is_supported()) {
+        return false;
+    }
+
+    event = queue.call_every(period, callback(this, &HD44780Marquee::step));
+    if (event == 0) {
+        return false;
+    }
+
+    this->queue = &queue;
+    return true;
+}
+
+void
+HD44780Marquee::stop() {
+
+    if (queue == nullptr) {
+        return;
+    }
+
+    // on the thread that dispatches the queue no step can be running here, so cancelling it is enough (see the
+    // attention notes of the method)
+    queue->cancel(event);
+    queue = nullptr;
+}
+
+bool
+HD44780Marquee::is_running() const {
+    return queue != nullptr;
+}
+
+// private methods
+
+bool
+HD44780Marquee::is_supported() const {
+
+    // each row must start at the beginning of its own line, so that it wraps around within it when shifted
+    return lcd.get_geometry().has_row_per_line();
+}
+
+uint8_t
+HD44780Marquee::char_at(uint32_t r, uint32_t pos) const {
+
+    return (pos < lengths[r])
+    ? texts[r][pos]
+    : ' ';
+}
+
+void
+HD44780Marquee::load() {
+
+    const uint32_t lineSize = lcd.get_line_size();
+    const uint32_t rows = lcd.get_row_count();
+
+    uint8_t line[80];
+
+    // returning home also undoes the shift of the display
+    lcd.set_cursor_home();
+
+    for (uint32_t r = 0; r < rows; ++r) {
+
+        if (periods[r] == 0) {
+            periods[r] = lineSize;
+        }
+
+        for (uint32_t c = 0; c < lineSize; ++c) {
+            line[c] = char_at(r, c);
+        }
+
+        lcd.set_cursor_pos(r, 0);
+        lcd.send_buffer(line, lineSize);
+
+        positions[r] = 0;
+    }
+
+    shift = 0;
+    loaded = true;
+}
@@ -0,0 +1,178 @@
+/**
+ * @file                    HD44780Marquee.h
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Scrolling marquee for HD44780 LCDs, moved by the display shift instruction of the LCD
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#ifndef __HD44780MARQUEE_H__
+#define __HD44780MARQUEE_H__
+
+#include "HD44780LCD.h"
+
+/**
+ * @brief                   Class that scrolls text across the rows of an LCD, by loading it into the whole line of the
+ *                          DDRAM (including the columns past the visible ones) once and shifting the display by a
+ *                          single instruction on each step
+ *
+ * @remark                  Text that fits in a line (along with the gap) is never written again, longer text only has
+ *                          the cell that just scrolled out of view rewritten with the character that follows, and only
+ *                          if it differs
+ *
+ * @remark                  The display shift moves all rows together, so the marquee takes over the whole display, and
+ *                          only modules in which every row is a separate line of the DDRAM (up to 2 rows) are supported
+ *
+ * @remark                  Cells are written with the cursor auto-increment entry mode in mind, and the cursor should
+ *                          be hidden while the marquee runs
+ *
+ * @remark                  Cancelling the steps does not wait for one that is already running, so a started marquee
+ *                          must be stopped (or destroyed) on the thread that dispatches its queue, or while the queue is
+ *                          not being dispatched
+ *
+ * @example                 To scroll a message across a 16x2 module at 5Hz
+ * @code
+ * EventQueue queue;
+ * HD44780Marquee marquee(lcd);
+ *
+ * marquee.set_text(0, "Departures: 10:42 Central, 10:57 Harbour, 11:05 Airport");
+ * marquee.set_text(1, "Platform 3");
+ * marquee.start(queue, 200ms);
+ *
+ * queue.dispatch_forever();
+ * @endcode
+ *
+ */
+class HD44780Marquee {
+
+    /** Maximum number of rows that can scroll (the two lines of the DDRAM) */
+    static constexpr uint32_t   MAX_ROWS    = 2;
+
+    /** LCD on which the text scrolls */
+    HD44780LCD      &lcd;
+    /** Number of blank cells between the end of the text and its next repetition */
+    uint32_t        gap;
+
+    /** Text scrolled on each row (not copied, must outlive the marquee) */
+    const char      *texts[MAX_ROWS] {nullptr};
+    /** Number of characters in each text */
+    uint32_t        lengths[MAX_ROWS] {0};
+    /** Number of cells after which the contents of each row repeat (at least the size of a line) */
+    uint32_t        periods[MAX_ROWS] {0};
+    /** Position (within the period) of the character in the leftmost cell of the line the display starts at */
+    uint32_t        positions[MAX_ROWS] {0};
+
+    /** Number of cells the display has been shifted left by since the text was loaded (within a line) */
+    uint32_t        shift {0};
+    /** Whether the text has been loaded into the DDRAM since it was last set */
+    bool            loaded {false};
+
+    /** Queue on which the steps are run (if started) */
+    EventQueue      *queue {nullptr};
+    /** Identifier of the periodic event on ```queue``` */
+    int             event {0};
+
+    /**
+     * @brief               Check whether the marquee can run on the layout of the LCD
+     *
+     * @return true         If every row is a separate line of the DDRAM
+     * @return false        Otherwise
+     */
+    bool            is_supported() const;
+
+    /**
+     * @brief               Get the character at a position of the contents of a row
+     *
+     * @param r             Row of the contents
+     * @param pos           Position within the period of the row
+     * @return uint8_t      Character at the position (blank within the gap)
+     */
+    uint8_t         char_at(uint32_t r, uint32_t pos) const;
+
+    /**
+     * @brief               Return the display home and write the first line of contents of every row
+     *
+     */
+    void            load();
+
+public:
+
+    HD44780Marquee() = delete;
+
+    HD44780Marquee(const HD44780Marquee &) = delete;
+
+    /**
+     * @brief               Construct a new HD44780Marquee object
+     *
+     * @param lcd           LCD on which the text scrolls (must be initialized before the first step)
+     * @param gap           Minimum number of blank cells between the end of the text and its next repetition
+     *
+     */
+    explicit HD44780Marquee(HD44780LCD &lcd, uint32_t gap = 4);
+
+    /**
+     * @brief               Destroy the HD44780Marquee object, stopping it first
+     *
+     * @attention           If the marquee is running, must be called from the thread that dispatches its queue (or
+     *                      while the queue is not being dispatched), see ```HD44780Marquee::stop()```
+     *
+     */
+    ~HD44780Marquee();
+
+    /**
+     * @brief               Set the text that scrolls on a row (the display returns home and the text is loaded again
+     *                      on the next step)
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     * @param r             Row on which the text scrolls
+     * @param text          Text to scroll (not copied, must outlive the marquee), or ```nullptr``` to leave the row
+     *                      blank
+     */
+    void            set_text(uint32_t r, const char *text);
+
+    /**
+     * @brief               Scroll the text by one cell to the left
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     */
+    void            step();
+
+    /**
+     * @brief               Start scrolling the text periodically on an event queue
+     *
+     * @param queue         Queue on which the steps are run (must outlive the marquee or be stopped first)
+     * @param period        Time between consecutive steps
+     * @return true         If the marquee was started
+     * @return false        If it is already running, the layout of the LCD is not supported or the queue is full
+     */
+    bool            start(EventQueue &queue, std::chrono::milliseconds period);
+
+    /**
+     * @brief               Stop scrolling the text (the display is left where it is)
+     *
+     * @remark              A step that is already running on the queue is not waited for (```EventQueue::cancel()```
+     *                      can not cancel it)
+     *
+     * @attention           Can not call this method from ISR context
+     * @attention           Must be called from the thread that dispatches the queue, or while the queue is not being
+     *                      dispatched, so that no step can be running (or about to access the marquee) when it returns
+     *
+     */
+    void            stop();
+
+    /**
+     * @brief               Check whether the marquee is scrolling on an event queue
+     *
+     * @attention           This method can be called from ISR context
+     *
+     * @return true         If the marquee has been started and not stopped
+     * @return false        Otherwise
+     */
+    bool            is_running() const;
+};
+
+#endif //__HD44780MARQUEE_H__
@@ -0,0 +1,145 @@
+/**
+ * @file                    HD44780Pager.cpp
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Double-buffered pages for HD44780 LCDs, kept in the columns of the DDRAM past the visible ones
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#include "HD44780Pager.h"
+
+/** number of cells in the longest line of the DDRAM (single-line mode) */
+constexpr uint32_t  MAX_LINE_SIZE       = 80;
+
+// Constructors
+
+HD44780Pager::HD44780Pager(HD44780LCD &lcd)
+        : lcd {lcd}
+        , pageCount {lcd.get_geometry().has_row_per_line() ? (lcd.get_line_size() / lcd.get_col_count()) : 1}
+{
+}
+
+// public methods
+
+uint32_t
+HD44780Pager::get_page_count() const {
+    return pageCount;
+}
+
+uint32_t
+HD44780Pager::get_visible_page() const {
+    return visiblePage;
+}
+
+uint32_t
+HD44780Pager::get_back_page() const {
+    return (visiblePage + 1) % pageCount;
+}
+
+uint32_t
+HD44780Pager::write(uint32_t page, uint32_t r, uint32_t c, const uint8_t *buf, uint32_t len) {
+
+    const uint32_t cols = lcd.get_col_count();
+
+    if (page >= pageCount || r >= lcd.get_row_count() || c >= cols) {
+        return 0;
+    }
+
+    auto count = (len < (cols - c)) ? len : (cols - c);
+
+    lcd.set_cursor_pos(r, (page * cols) + c);
+    lcd.send_buffer(buf, count);
+
+    return count;
+}
+
+int
+HD44780Pager::printf_at(uint32_t page, uint32_t r, uint32_t c, const char *fmt, ...) {
+
+    if (page >= pageCount || r >= lcd.get_row_count() || c >= lcd.get_col_count()) {
+        return -1;
+    }
+
+    // a row of a page is never longer than a line of the DDRAM, so it fits in a small buffer on the stack (with room
+    // for characters of up to 3 bytes in UTF-8)
+    char buf[(3 * MAX_LINE_SIZE) + 1];
+
+    std::va_list args;
+
+    va_start(args, fmt);
+    auto len = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+
+    if (len < 0) {
+        return len;
+    }
+
+    if ((uint32_t)len >= sizeof(buf)) {
+        len = sizeof(buf) - 1;
+    }
+
+    // the text is translated like that of the LCD's own printf_at(), under the same lock as the write
+    lcd.lock();
+
+    len = lcd.translate_in_place(buf, len);
+    len = write(page, r, c, (const uint8_t *)buf, len);
+
+    lcd.unlock();
+
+    return len;
+}
+
+void
+HD44780Pager::clear_page(uint32_t page) {
+
+    uint8_t blanks[MAX_LINE_SIZE];
+    memset(blanks, ' ', sizeof(blanks));
+
+    HD44780LCD::Transaction transaction(lcd);
+
+    for (uint32_t r = 0; r < lcd.get_row_count(); ++r) {
+        write(page, r, 0, blanks, lcd.get_col_count());
+    }
+}
+
+void
+HD44780Pager::show_page(uint32_t page) {
+
+    if (page >= pageCount || page == visiblePage) {
+        return;
+    }
+
+    const uint32_t lineSize = lcd.get_line_size();
+    const uint32_t cols = lcd.get_col_count();
+
+    // the display wraps around the line, so it is shifted whichever way is shorter
+    const uint32_t left = ((page * cols) + lineSize - (visiblePage * cols)) % lineSize;
+    const uint32_t right = lineSize - left;
+
+    HD44780LCD::Transaction transaction(lcd);
+
+    // in buffered mode the cells written to the page are sent before the shift, rather than when the guard flushes
+    // the frame, so that the page never appears half written
+    if (lcd.is_buffering_enabled()) {
+        lcd.flush();
+    }
+
+    // returning home undoes the shift in a single instruction, so that the page appears at once
+    if (page == 0 && left > 1 && right > 1) {
+        lcd.set_cursor_home();
+    }
+    else if (left <= right) {
+        for (uint32_t i = 0; i < left; ++i) {
+            lcd.scroll_display_left();
+        }
+    }
+    else {
+        for (uint32_t i = 0; i < right; ++i) {
+            lcd.scroll_display_right();
+        }
+    }
+
+    visiblePage = page;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file                    HD44780Pager.h
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Double-buffered pages for HD44780 LCDs, kept in the columns of the DDRAM past the visible ones
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#ifndef __HD44780PAGER_H__
+#define __HD44780PAGER_H__
+
+#include "HD44780LCD.h"
+
+/**
+ * @brief                   Class that splits each line of the DDRAM into pages as wide as the display, so that the next
+ *                          screen can be written into a hidden page while the current one stays visible, and then be
+ *                          shown at once by shifting the display to it
+ *
+ * @remark                  A 16x2 module has 2 pages (columns 0 to 15 and 16 to 31 of each line), a 16x1 module in
+ *                          single-line mode has 5, and modules without hidden columns (such as 40x2) have a single page
+ *
+ * @remark                  Showing a page costs one shift instruction per column it is away from the visible one (the
+ *                          shorter way around the line), or a single return home instruction for the first page
+ *
+ * @remark                  The display shift moves all rows together, so pages are only supported on modules in which
+ *                          every row is a separate line of the DDRAM (up to 2 rows), the pager must be the only one
+ *                          scrolling the display, and the cursor should be hidden
+ *
+ * @example                 To prepare the next screen while the current one is visible
+ * @code
+ * HD44780Pager pager(lcd);
+ *
+ * auto page = pager.get_back_page();
+ * pager.clear_page(page);
+ * pager.printf_at(page, 0, 0, "Temp: %5.1f", temp);
+ * pager.printf_at(page, 1, 0, "Hum:  %5.1f", hum);
+ * pager.show_page(page);
+ * @endcode
+ *
+ */
+class HD44780Pager {
+
+    /** LCD on which the pages are shown */
+    HD44780LCD      &lcd;
+
+    /** Number of pages that fit in a line of the DDRAM */
+    uint32_t        pageCount;
+    /** Page the display is shifted to */
+    uint32_t        visiblePage {0};
+
+public:
+
+    HD44780Pager() = delete;
+
+    HD44780Pager(const HD44780Pager &) = delete;
+
+    /**
+     * @brief               Construct a new HD44780Pager object
+     *
+     * @remark              The display must not have been scrolled, the first page is taken to be visible
+     *
+     * @param lcd           LCD on which the pages are shown
+     *
+     */
+    explicit HD44780Pager(HD44780LCD &lcd);
+
+    /**
+     * @brief               Get the number of pages
+     *
+     * @attention           This method can be called from ISR context
+     *
+     * @return uint32_t     Number of pages (1 if the layout of the LCD is not supported)
+     */
+    uint32_t        get_page_count() const;
+
+    /**
+     * @brief               Get the page that is visible
+     *
+     * @attention           This method can be called from ISR context
+     *
+     * @return uint32_t     Visible page
+     */
+    uint32_t        get_visible_page() const;
+
+    /**
+     * @brief               Get the page after the visible one (the first page after the last), which is hidden unless
+     *                      there is a single page
+     *
+     * @attention           This method can be called from ISR context
+     *
+     * @return uint32_t     Page after the visible one
+     */
+    uint32_t        get_back_page() const;
+
+    /**
+     * @brief               Write characters into a row of a page, truncated at the end of the row
+     *
+     * @remark              This method alters the cursor position
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     * @param page          Page to write to
+     * @param r             Row of the first character
+     * @param c             Column (within the page) of the first character
+     * @param buf           Pointer to array of characters
+     * @param len           Number of characters to pick from the buffer
+     * @return uint32_t     Number of characters written
+     */
+    uint32_t        write(uint32_t page, uint32_t r, uint32_t c, const uint8_t *buf, uint32_t len);
+
+    /**
+     * @brief               Format a string and write it into a row of a page, truncated at the end of the row
+     *
+     * @remark              This method alters the cursor position
+     *
+     * @remark              UTF-8 input is translated as by ```HD44780LCD::printf_at()``` (see
+     *                      ```HD44780LCD::set_charset()```)
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     * @param page          Page to write to
+     * @param r             Row of the first character
+     * @param c             Column (within the page) of the first character
+     * @param fmt           Format string (as used by printf)
+     * @return int          Number of characters written, or a negative value if formatting failed or the position is
+     *                      outside the page
+     */
+    int             printf_at(uint32_t page, uint32_t r, uint32_t c, const char *fmt, ...) MBED_PRINTF_METHOD(4, 5);
+
+    /**
+     * @brief               Fill all rows of a page with blanks
+     *
+     * @remark              This method alters the cursor position
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     * @param page          Page to clear
+     */
+    void            clear_page(uint32_t page);
+
+    /**
+     * @brief               Shift the display to a page
+     *
+     * @remark              This method alters the cursor position (returning to the first page is done by returning
+     *                      the cursor home)
+     *
+     * @remark              In buffered mode, the characters written to the page are flushed before the display is
+     *                      shifted
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     * @param page          Page to show
+     */
+    void            show_page(uint32_t page);
+};
+
+#endif //__HD44780PAGER_H__
@@ -0,0 +1,229 @@
+/**
+ * @file                    HD44780ParallelBus.cpp
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Transport that drives the pins of an HD44780 LCD directly from GPIO, in half-bus (4-bit) or
+ *                          full-bus (8-bit) mode
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#include "HD44780ParallelBus.h"
+
+// Constructors
+
+HD44780ParallelBus::HD44780ParallelBus(PinName rs, PinName en, PinName d4, PinName d5, PinName d6, PinName d7,
+        PinName rw, PinName backlight)
+        : rs(rs, 0)
+        , en(en, 0)
+        , rw(rw, 0)
+        , backlight(backlight, 0)
+        , data(std::in_place, d4, d5, d6, d7)
+        , width {4}
+{
+    setup();
+}
+
+HD44780ParallelBus::HD44780ParallelBus(PinName rs, PinName en, PinName d0, PinName d1, PinName d2, PinName d3,
+        PinName d4, PinName d5, PinName d6, PinName d7, PinName rw, PinName backlight)
+        : rs(rs, 0)
+        , en(en, 0)
+        , rw(rw, 0)
+        , backlight(backlight, 0)
+        , data(std::in_place, d0, d1, d2, d3, d4, d5, d6, d7)
+        , width {8}
+{
+    setup();
+}
+
+#if DEVICE_PORTINOUT
+HD44780ParallelBus::HD44780ParallelBus(PinName rs, PinName en, PortName port, uint32_t shift, uint32_t width,
+        PinName rw, PinName backlight)
+        : rs(rs, 0)
+        , en(en, 0)
+        , rw(rw, 0)
+        , backlight(backlight, 0)
+        , port(std::in_place, port, ((width == 8) ? 0xff : 0x0f) << shift)
+        , shift {shift}
+        , width {(width == 8) ? 8u : 4u}
+{
+    setup();
+}
+#endif // DEVICE_PORTINOUT
+
+void
+HD44780ParallelBus::setup() {
+
+    set_data_input(false);
+    write_data(0);
+}
+
+// public methods
+
+uint32_t
+HD44780ParallelBus::get_bus_width() const {
+    return width;
+}
+
+void
+HD44780ParallelBus::send_byte(uint8_t byte, uint8_t isData, std::chrono::microseconds execTime) {
+
+    const auto begin = stats_begin();
+
+    count_bytes(isData, 1);
+    wait_ready();
+
+    if (width == 8) {
+        strobe(byte, isData);
+    }
+    else {
+
+        strobe(byte >> 4, isData);
+        strobe(byte & 0xf, isData);
+    }
+
+    mark_busy(execTime);
+    count_blocked(begin);
+}
+
+void
+HD44780ParallelBus::send_nibble(uint8_t nibble, uint8_t isData, std::chrono::microseconds execTime) {
+
+    const auto begin = stats_begin();
+
+    count_bytes(isData, 1);
+    wait_ready();
+
+    // in full-bus mode, the nibble is presented on the upper data pins, with the lower ones held low
+    strobe((width == 8) ? ((nibble & 0xf) << 4) : (nibble & 0xf), isData);
+
+    mark_busy(execTime);
+    count_blocked(begin);
+}
+
+void
+HD44780ParallelBus::enable_backlight() {
+
+    backlightOn = true;
+    backlight = 1;
+}
+
+void
+HD44780ParallelBus::disable_backlight() {
+
+    backlightOn = false;
+    backlight = 0;
+}
+
+void
+HD44780ParallelBus::toggle_backlight() {
+
+    backlightOn = !backlightOn;
+    backlight = backlightOn ? 1 : 0;
+}
+
+bool
+HD44780ParallelBus::is_backlight_on() const {
+    return backlightOn;
+}
+
+bool
+HD44780ParallelBus::is_readable() const {
+    return rw.is_connected();
+}
+
+// protected methods
+
+uint8_t
+HD44780ParallelBus::poll_status() {
+
+    if (!rw.is_connected()) {
+        return 0;
+    }
+
+    // the data pins are released before RW is raised, so that they never drive against the LCD
+    set_data_input(true);
+
+    rs = 0;
+    rw = 1;
+
+    uint8_t status = sample();
+    if (width == 4) {
+        status = (status << 4) | sample();
+    }
+
+    rw = 0;
+    set_data_input(false);
+
+    return status;
+}
+
+// private methods
+
+void
+HD44780ParallelBus::strobe(uint8_t bits, uint8_t isData) {
+
+    rs = isData ? 1 : 0;
+    write_data(bits);
+
+    en = 1;
+    wait_ns(ENABLE_PULSE_NS);
+    en = 0;
+    wait_ns(ENABLE_HOLD_NS);
+}
+
+uint8_t
+HD44780ParallelBus::sample() {
+
+    en = 1;
+    wait_ns(ENABLE_PULSE_NS);
+
+    uint8_t bits = read_data();
+
+    en = 0;
+    wait_ns(ENABLE_HOLD_NS);
+
+    return bits;
+}
+
+void
+HD44780ParallelBus::write_data(uint8_t bits) {
+
+#if DEVICE_PORTINOUT
+    if (port) {
+
+        // the bits outside the mask are left as they are, so that the rest of the port can be used for other pins
+        port->write((uint32_t)bits << shift);
+        return;
+    }
+#endif // DEVICE_PORTINOUT
+
+    *data = bits;
+}
+
+uint8_t
+HD44780ParallelBus::read_data() {
+
+#if DEVICE_PORTINOUT
+    if (port) {
+        return (port->read() >> shift) & ((width == 8) ? 0xff : 0x0f);
+    }
+#endif // DEVICE_PORTINOUT
+
+    return data->read();
+}
+
+void
+HD44780ParallelBus::set_data_input(bool input) {
+
+#if DEVICE_PORTINOUT
+    if (port) {
+
+        input ? port->input() : port->output();
+        return;
+    }
+#endif // DEVICE_PORTINOUT
+
+    input ? data->input() : data->output();
+}
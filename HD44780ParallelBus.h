@@ -0,0 +1,205 @@
+/**
+ * @file                    HD44780ParallelBus.h
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Transport that drives the pins of an HD44780 LCD directly from GPIO, in half-bus (4-bit) or
+ *                          full-bus (8-bit) mode
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#ifndef __HD44780PARALLELBUS_H__
+#define __HD44780PARALLELBUS_H__
+
+#include "HD44780Bus.h"
+
+#include <optional>
+
+/**
+ * @brief                   Class that drives the RS, EN and data pins of an LCD directly from the pins of the
+ *                          microcontroller
+ *
+ * @remark                  If the data pins are wired to consecutive bits of a single port, constructing the transport
+ *                          from the port writes a whole byte (or nibble) in a single port store, otherwise the pins are
+ *                          driven through a ```BusInOut```, which writes them one at a time (well within the setup time
+ *                          before EN rises, at the cost of a few more cycles per transfer)
+ *
+ * @remark                  The RW pin is optional, if it is tied to ground the status can not be read back and the busy
+ *                          flag can not be polled (the execution times are waited out instead)
+ *
+ * @remark                  The backlight pin is optional, and should switch the backlight through a transistor
+ *
+ * @example                 To drive a module in half-bus mode
+ * @code
+ * HD44780ParallelBus bus(D8, D9, D4, D5, D6, D7);
+ * HD44780LCD lcd(bus);
+ *
+ * lcd.initialize();
+ * lcd.printf("Hello World!");
+ * @endcode
+ *
+ * @example                 To drive a module in full-bus mode with DB0 to DB7 wired to PC0 to PC7
+ * @code
+ * HD44780ParallelBus bus(D8, D9, PortC, 0, 8);
+ * @endcode
+ *
+ */
+class HD44780ParallelBus : public HD44780Bus {
+
+    /** Time for which EN is held high to latch a transfer (datasheet value, at least 230ns at 5V and 450ns at 3V) */
+    static constexpr uint32_t   ENABLE_PULSE_NS = 450;
+    /** Time for which EN is held low before the next transfer (datasheet value, completing the 1000ns cycle at 3V) */
+    static constexpr uint32_t   ENABLE_HOLD_NS  = 550;
+
+    /** Pin connected to the RS pin of the LCD */
+    DigitalOut  rs;
+    /** Pin connected to the EN pin of the LCD */
+    DigitalOut  en;
+    /** Pin connected to the RW pin of the LCD (not connected if tied to ground) */
+    DigitalOut  rw;
+    /** Pin that switches the backlight of the LCD (not connected if the backlight is always on) */
+    DigitalOut  backlight;
+    /** Pins connected to the data pins of the LCD (DB4 to DB7 in half-bus mode, DB0 to DB7 in full-bus mode), if they
+     * are not wired to a single port */
+    std::optional<BusInOut>     data;
+#if DEVICE_PORTINOUT
+    /** Port whose consecutive bits are connected to the data pins of the LCD (if constructed from a port) */
+    std::optional<PortInOut>    port;
+#endif // DEVICE_PORTINOUT
+    /** Bit of ```port``` connected to the lowest data pin of the LCD */
+    uint32_t    shift {0};
+
+    /** Number of data pins that are connected */
+    uint32_t    width;
+    /** Whether the backlight is switched on */
+    bool        backlightOn {false};
+
+    /**
+     * @brief               Present bits on the data pins and pulse EN to latch them into the LCD
+     *
+     * @param bits          Bits to present (a nibble in half-bus mode, a byte in full-bus mode)
+     * @param isData        Whether the bits are data or part of an instruction
+     */
+    void            strobe(uint8_t bits, uint8_t isData);
+
+    /**
+     * @brief               Read the data pins while EN is held high
+     *
+     * @return uint8_t      Bits presented by the LCD
+     */
+    uint8_t         sample();
+
+    /**
+     * @brief               Present bits on the data pins (in a single store if they are wired to a port)
+     *
+     * @param bits          Bits to present (a nibble in half-bus mode, a byte in full-bus mode)
+     */
+    void            write_data(uint8_t bits);
+
+    /**
+     * @brief               Read the data pins
+     *
+     * @return uint8_t      Bits on the data pins
+     */
+    uint8_t         read_data();
+
+    /**
+     * @brief               Switch the data pins between driving the LCD and being driven by it
+     *
+     * @param input         Whether the pins should be inputs (while reading from the LCD)
+     */
+    void            set_data_input(bool input);
+
+    /**
+     * @brief               Set the initial state of the pins (common to all constructors)
+     *
+     */
+    void            setup();
+
+protected:
+
+    /**
+     * @brief               Read the busy flag and address counter of the LCD without waiting for it to be ready
+     *
+     * @return uint8_t      Busy flag in the most significant bit, address counter in the remaining bits
+     */
+    uint8_t         poll_status() override;
+
+public:
+
+    HD44780ParallelBus() = delete;
+
+    /**
+     * @brief               Construct a new HD44780ParallelBus object in half-bus (4-bit) mode
+     *
+     * @param rs            Pin connected to the RS pin of the LCD
+     * @param en            Pin connected to the EN pin of the LCD
+     * @param d4            Pin connected to the DB4 pin of the LCD
+     * @param d5            Pin connected to the DB5 pin of the LCD
+     * @param d6            Pin connected to the DB6 pin of the LCD
+     * @param d7            Pin connected to the DB7 pin of the LCD
+     * @param rw            Pin connected to the RW pin of the LCD (```NC``` if it is tied to ground)
+     * @param backlight     Pin that switches the backlight of the LCD (```NC``` if there is none)
+     *
+     */
+    HD44780ParallelBus(PinName rs, PinName en, PinName d4, PinName d5, PinName d6, PinName d7, PinName rw = NC,
+            PinName backlight = NC);
+
+    /**
+     * @brief               Construct a new HD44780ParallelBus object in full-bus (8-bit) mode
+     *
+     * @param rs            Pin connected to the RS pin of the LCD
+     * @param en            Pin connected to the EN pin of the LCD
+     * @param d0            Pin connected to the DB0 pin of the LCD
+     * @param d1            Pin connected to the DB1 pin of the LCD
+     * @param d2            Pin connected to the DB2 pin of the LCD
+     * @param d3            Pin connected to the DB3 pin of the LCD
+     * @param d4            Pin connected to the DB4 pin of the LCD
+     * @param d5            Pin connected to the DB5 pin of the LCD
+     * @param d6            Pin connected to the DB6 pin of the LCD
+     * @param d7            Pin connected to the DB7 pin of the LCD
+     * @param rw            Pin connected to the RW pin of the LCD (```NC``` if it is tied to ground)
+     * @param backlight     Pin that switches the backlight of the LCD (```NC``` if there is none)
+     *
+     */
+    HD44780ParallelBus(PinName rs, PinName en, PinName d0, PinName d1, PinName d2, PinName d3, PinName d4, PinName d5,
+            PinName d6, PinName d7, PinName rw = NC, PinName backlight = NC);
+
+#if DEVICE_PORTINOUT
+    /**
+     * @brief               Construct a new HD44780ParallelBus object with the data pins wired to consecutive bits of a
+     *                      single port, so that each transfer presents them in a single store
+     *
+     * @param rs            Pin connected to the RS pin of the LCD
+     * @param en            Pin connected to the EN pin of the LCD
+     * @param port          Port whose bits are connected to the data pins of the LCD
+     * @param shift         Bit of the port connected to DB4 (half-bus mode) or DB0 (full-bus mode), the other data pins
+     *                      being connected in order to the following bits
+     * @param width         Number of data pins that are connected (4 for half-bus mode, 8 for full-bus mode)
+     * @param rw            Pin connected to the RW pin of the LCD (```NC``` if it is tied to ground)
+     * @param backlight     Pin that switches the backlight of the LCD (```NC``` if there is none)
+     *
+     */
+    HD44780ParallelBus(PinName rs, PinName en, PortName port, uint32_t shift, uint32_t width = 4, PinName rw = NC,
+            PinName backlight = NC);
+#endif // DEVICE_PORTINOUT
+
+    uint32_t        get_bus_width() const override;
+
+    void            send_byte(uint8_t byte, uint8_t isData, std::chrono::microseconds execTime = EXEC_TIME) override;
+
+    void            send_nibble(uint8_t nibble, uint8_t isData, std::chrono::microseconds execTime = EXEC_TIME) override;
+
+    void            enable_backlight() override;
+
+    void            disable_backlight() override;
+
+    void            toggle_backlight() override;
+
+    bool            is_backlight_on() const override;
+
+    bool            is_readable() const override;
+};
+
+#endif //__HD44780PARALLELBUS_H__
@@ -0,0 +1,313 @@
+/**
+ * @file                    HD44780Screen.h
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Fixed screens for HD44780 LCDs, encoded into the outputs of the PC8574 chip at compile time
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#ifndef __HD44780SCREEN_H__
+#define __HD44780SCREEN_H__
+
+#include "HD44780LCD.h"
+
+/**
+ * @brief                   Class that describes a fixed screen (the contents of all visible cells, the state of the
+ *                          display and cursor and the position of the cursor) and holds the exact outputs of the PC8574
+ *                          chip that show it, computed at compile time when declared ```constexpr```
+ *
+ * @remark                  Showing the screen with ```HD44780LCD::show_screen()``` sends the precomputed outputs in a
+ *                          single I2C transaction, without encoding any byte at runtime
+ *
+ * @remark                  The screen sets the entry mode of the LCD to move the cursor right after each character, and
+ *                          assumes that the display has not been scrolled
+ *
+ * @example                 To declare a boot screen in flash and show it
+ * @code
+ * static constexpr HD44780Screen BOOT_SCREEN = HD44780Screen()
+ *         .text(0, 0, "Booting...")
+ *         .text(1, 0, "fw 1.2.3");
+ *
+ * lcd.show_screen(BOOT_SCREEN);
+ * @endcode
+ *
+ */
+class HD44780Screen {
+
+    /** Maximum number of visible cells on the display (20x4 and 40x2 modules) */
+    static constexpr uint32_t   MAX_CELLS       = 80;
+    /** Number of outputs of the PC8574 chip that send a byte (two nibbles, each with a pulse on EN) */
+    static constexpr uint32_t   BYTE_OUTPUTS    = 6;
+    /** Maximum number of outputs (entry mode, one address per row, all cells, display control, cursor address) */
+    static constexpr uint32_t   MAX_OUTPUTS     = (1 + 4 + MAX_CELLS + 1 + 1) * BYTE_OUTPUTS;
+
+    /** instruction to move the cursor right after each character, without scrolling the display */
+    static constexpr uint8_t    ENTRY_MODE_INC  = 0x06;
+    /** instruction to control the display (combined with the state of the display, cursor and blink) */
+    static constexpr uint8_t    CONTROL_DISPLAY = 0x08;
+    /** mask of the display in the state */
+    static constexpr uint8_t    DISPLAY_ENABLE  = 0x04;
+    /** mask of the underline cursor in the state */
+    static constexpr uint8_t    CURSOR_ENABLE   = 0x02;
+    /** mask of the blinking cursor in the state */
+    static constexpr uint8_t    BLINK_ENABLE    = 0x01;
+    /** instruction to set the address in the DDRAM (combined with the address) */
+    static constexpr uint8_t    SET_DDRAMADDR   = 0x80;
+
+    /** Layout of the module the screen is encoded for */
+    HD44780LCD::Geometry    geometry;
+    /** Mapping of the outputs of the PC8574 chip the screen is encoded for */
+    HD44780LCD::PinMap      pins;
+    /** Whether the backlight is switched on in the outputs */
+    bool                    backlight;
+
+    /** Characters in the visible cells (row-major) */
+    uint8_t                 cells[MAX_CELLS] {};
+    /** Bitmask containing the enabled/disabled states of the display, underline cursor and blinking cursor */
+    uint8_t                 displayState {DISPLAY_ENABLE};
+    /** Row in which the cursor is left */
+    uint8_t                 cursorRow {0};
+    /** Column in which the cursor is left */
+    uint8_t                 cursorCol {0};
+
+    /** Outputs of the PC8574 chip that show the screen */
+    uint8_t                 outputs[MAX_OUTPUTS] {};
+    /** Number of outputs in ```outputs``` */
+    uint32_t                length {0};
+
+    /**
+     * @brief               Append the outputs that send a byte to the LCD (in the same way as ```HD44780LCD```)
+     *
+     * @param byte          Byte to send
+     * @param isData        Whether the byte is a character (otherwise an instruction)
+     */
+    constexpr void          encode_byte(uint8_t byte, bool isData) {
+
+        for (uint32_t _ = 0; _ <= 4; _ += 4) {
+
+            uint8_t result = pins.encode_nibble((byte >> (4 ^ _)) & 0xf)
+                    | (isData ? (1 << pins.rs) : 0)
+                    | (backlight ? (1 << pins.backlight) : 0);
+
+            outputs[length++] = result;
+            outputs[length++] = result | (1 << pins.en);
+            outputs[length++] = result;
+        }
+    }
+
+    /**
+     * @brief               Compute the outputs that show the screen from its description
+     *
+     */
+    constexpr void          encode() {
+
+        length = 0;
+
+        encode_byte(ENTRY_MODE_INC, false);
+
+        for (uint32_t r = 0; r < geometry.rows; ++r) {
+
+            encode_byte(SET_DDRAMADDR | geometry.address(r, 0), false);
+            for (uint32_t c = 0; c < geometry.cols; ++c) {
+                encode_byte(cells[(r * geometry.cols) + c], true);
+            }
+        }
+
+        encode_byte(CONTROL_DISPLAY | displayState, false);
+        encode_byte(SET_DDRAMADDR | geometry.address(cursorRow, cursorCol), false);
+    }
+
+public:
+
+    /**
+     * @brief               Construct a new HD44780Screen object with all cells blank
+     *
+     * @param geometry      Layout of the module the screen is shown on (rows times columns must not exceed 80)
+     * @param pins          Mapping of the outputs of the PC8574 chip of the module
+     * @param backlight     Whether the backlight should be switched on while the screen is shown (if this differs from
+     *                      the state of the LCD when shown, the state of the LCD is kept at the cost of re-encoding
+     *                      the outputs)
+     *
+     */
+    constexpr explicit HD44780Screen(const HD44780LCD::Geometry &geometry = HD44780LCD::GEOMETRY_16X2,
+            const HD44780LCD::PinMap &pins = HD44780LCD::DEFAULT_PIN_MAP, bool backlight = true)
+            : geometry {geometry}
+            , pins {pins}
+            , backlight {backlight}
+    {
+        for (auto &cell : cells) {
+            cell = ' ';
+        }
+        encode();
+    }
+
+    /**
+     * @brief               Get a copy of the screen with text placed at a position
+     *
+     * @param r             Row of the first character
+     * @param c             Column of the first character
+     * @param str           Text to place (truncated at the end of the row)
+     * @return HD44780Screen Copy of the screen with the text
+     */
+    constexpr HD44780Screen text(uint32_t r, uint32_t c, const char *str) const {
+
+        HD44780Screen screen = *this;
+
+        for (; r < geometry.rows && c < geometry.cols && *str != '\0'; ++c, ++str) {
+            screen.cells[(r * geometry.cols) + c] = *str;
+        }
+
+        screen.encode();
+        return screen;
+    }
+
+    /**
+     * @brief               Get a copy of the screen with a character (such as a custom character) at a position
+     *
+     * @param r             Row of the character
+     * @param c             Column of the character
+     * @param ch            Character to place
+     * @return HD44780Screen Copy of the screen with the character
+     */
+    constexpr HD44780Screen character(uint32_t r, uint32_t c, uint8_t ch) const {
+
+        HD44780Screen screen = *this;
+
+        if (r < geometry.rows && c < geometry.cols) {
+            screen.cells[(r * geometry.cols) + c] = ch;
+        }
+
+        screen.encode();
+        return screen;
+    }
+
+    /**
+     * @brief               Get a copy of the screen with the states of the display, underline cursor and blinking
+     *                      cursor set
+     *
+     * @param display       Whether the display is enabled
+     * @param cursor        Whether the underline cursor is displayed
+     * @param blink         Whether the blinking cursor is displayed
+     * @return HD44780Screen Copy of the screen with the states set
+     */
+    constexpr HD44780Screen display_control(bool display, bool cursor, bool blink) const {
+
+        HD44780Screen screen = *this;
+
+        screen.displayState = (display ? DISPLAY_ENABLE : 0)
+                | (cursor ? CURSOR_ENABLE : 0)
+                | (blink ? BLINK_ENABLE : 0);
+
+        screen.encode();
+        return screen;
+    }
+
+    /**
+     * @brief               Get a copy of the screen with the cursor left at a position
+     *
+     * @param r             Row of the cursor
+     * @param c             Column of the cursor (must be a visible column)
+     * @return HD44780Screen Copy of the screen with the cursor at the position
+     */
+    constexpr HD44780Screen cursor_pos(uint32_t r, uint32_t c) const {
+
+        HD44780Screen screen = *this;
+
+        if (r < geometry.rows && c < geometry.cols) {
+
+            screen.cursorRow = r;
+            screen.cursorCol = c;
+        }
+
+        screen.encode();
+        return screen;
+    }
+
+    /**
+     * @brief               Get the outputs of the PC8574 chip that show the screen
+     *
+     * @return const uint8_t* Outputs to write to the chip in a single transaction
+     */
+    constexpr const uint8_t *get_outputs() const {
+        return outputs;
+    }
+
+    /**
+     * @brief               Get the number of outputs that show the screen
+     *
+     * @return uint32_t     Number of outputs
+     */
+    constexpr uint32_t      get_length() const {
+        return length;
+    }
+
+    /**
+     * @brief               Get the layout of the module the screen is encoded for
+     *
+     * @return const HD44780LCD::Geometry& Layout of the module
+     */
+    constexpr const HD44780LCD::Geometry &get_geometry() const {
+        return geometry;
+    }
+
+    /**
+     * @brief               Get the mapping of the outputs of the PC8574 chip the screen is encoded for
+     *
+     * @return const HD44780LCD::PinMap& Mapping of the outputs
+     */
+    constexpr const HD44780LCD::PinMap &get_pin_map() const {
+        return pins;
+    }
+
+    /**
+     * @brief               Check whether the backlight is switched on in the outputs
+     *
+     * @return true         If the backlight is switched on
+     * @return false        Otherwise
+     */
+    constexpr bool          is_backlight_on() const {
+        return backlight;
+    }
+
+    /**
+     * @brief               Get the character in a visible cell of the screen
+     *
+     * @param r             Row of the cell
+     * @param c             Column of the cell
+     * @return uint8_t      Character in the cell
+     */
+    constexpr uint8_t       get_cell(uint32_t r, uint32_t c) const {
+        return cells[(r * geometry.cols) + c];
+    }
+
+    /**
+     * @brief               Get the states of the display, underline cursor and blinking cursor
+     *
+     * @return uint8_t      Bitmask of the states (as used by the display control instruction)
+     */
+    constexpr uint8_t       get_display_state() const {
+        return displayState;
+    }
+
+    /**
+     * @brief               Get the row in which the cursor is left
+     *
+     * @return uint32_t     Row of the cursor
+     */
+    constexpr uint32_t      get_cursor_row() const {
+        return cursorRow;
+    }
+
+    /**
+     * @brief               Get the column in which the cursor is left
+     *
+     * @return uint32_t     Column of the cursor
+     */
+    constexpr uint32_t      get_cursor_col() const {
+        return cursorCol;
+    }
+};
+
+#endif //__HD44780SCREEN_H__
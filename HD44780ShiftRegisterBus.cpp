@@ -0,0 +1,146 @@
+/**
+ * @file                    HD44780ShiftRegisterBus.cpp
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Transport that drives an HD44780 LCD in half-bus (4-bit) mode through a 74HC595 shift register
+ *                          on an SPI bus
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#include "HD44780ShiftRegisterBus.h"
+
+// Constructors
+
+HD44780ShiftRegisterBus::HD44780ShiftRegisterBus(PinName mosi, PinName sclk, PinName latch,
+        const HD44780LCD::PinMap &pinMap, int frequency)
+        : spi(mosi, NC, sclk)
+        , latch(latch, 0)
+        , pins {pinMap}
+{
+    spi.format(8, 0);
+    spi.frequency(frequency);
+
+    // the outputs start low (backlight off), matching the state reported by the LCD until it is switched on
+    lastOutput = 0;
+    shift_out(&lastOutput, 1);
+}
+
+// public methods
+
+void
+HD44780ShiftRegisterBus::send_byte(uint8_t byte, uint8_t isData, std::chrono::microseconds execTime) {
+
+    uint8_t outputs[2 * NIBBLE_OUTPUTS];
+
+    encode_nibble(&outputs[0], byte >> 4, isData);
+    encode_nibble(&outputs[NIBBLE_OUTPUTS], byte & 0xf, isData);
+
+    const auto begin = stats_begin();
+
+    count_bytes(isData, 1);
+    wait_ready();
+    shift_out(outputs, sizeof(outputs));
+    mark_busy(execTime);
+
+    count_blocked(begin);
+}
+
+void
+HD44780ShiftRegisterBus::send_nibble(uint8_t nibble, uint8_t isData, std::chrono::microseconds execTime) {
+
+    uint8_t outputs[NIBBLE_OUTPUTS];
+
+    encode_nibble(outputs, nibble & 0xf, isData);
+
+    const auto begin = stats_begin();
+
+    count_bytes(isData, 1);
+    wait_ready();
+    shift_out(outputs, sizeof(outputs));
+    mark_busy(execTime);
+
+    count_blocked(begin);
+}
+
+void
+HD44780ShiftRegisterBus::enable_backlight() {
+
+    backlightOn = true;
+
+    uint8_t output = lastOutput | (1 << pins.backlight);
+    shift_out(&output, 1);
+}
+
+void
+HD44780ShiftRegisterBus::disable_backlight() {
+
+    backlightOn = false;
+
+    uint8_t output = lastOutput & ~(1 << pins.backlight);
+    shift_out(&output, 1);
+}
+
+void
+HD44780ShiftRegisterBus::toggle_backlight() {
+
+    if (backlightOn) {
+        disable_backlight();
+    }
+    else {
+        enable_backlight();
+    }
+}
+
+bool
+HD44780ShiftRegisterBus::is_backlight_on() const {
+    return backlightOn;
+}
+
+bool
+HD44780ShiftRegisterBus::is_readable() const {
+    return false;
+}
+
+// protected methods
+
+uint8_t
+HD44780ShiftRegisterBus::poll_status() {
+    return 0;
+}
+
+// private methods
+
+void
+HD44780ShiftRegisterBus::shift_out(const uint8_t *outputs, uint32_t len) {
+
+    spi.lock();
+
+    // shifting out a byte takes longer than the minimum width of the pulse on EN, so no extra delay is needed
+    for (uint32_t idx = 0; idx < len; ++idx) {
+
+        spi.write(outputs[idx]);
+
+        latch = 1;
+        latch = 0;
+    }
+
+    spi.unlock();
+
+    if (len > 0) {
+        lastOutput = outputs[len - 1];
+    }
+}
+
+void
+HD44780ShiftRegisterBus::encode_nibble(uint8_t *outputs, uint8_t nibble, uint8_t isData) const {
+
+    uint8_t result = pins.encode_nibble(nibble)
+            | (isData ? (1 << pins.rs) : 0)
+            | (backlightOn ? (1 << pins.backlight) : 0);
+
+    outputs[0] = result;
+    outputs[1] = result | (1 << pins.en);
+    outputs[2] = result;
+}
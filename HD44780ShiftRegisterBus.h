@@ -0,0 +1,114 @@
+/**
+ * @file                    HD44780ShiftRegisterBus.h
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Transport that drives an HD44780 LCD in half-bus (4-bit) mode through a 74HC595 shift register
+ *                          on an SPI bus
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#ifndef __HD44780SHIFTREGISTERBUS_H__
+#define __HD44780SHIFTREGISTERBUS_H__
+
+#include "HD44780LCD.h"
+
+/**
+ * @brief                   Class that drives an LCD through the outputs (QA - QH) of a 74HC595 shift register, which are
+ *                          mapped to the pins of the LCD in the same way as the outputs of the PC8574 chip
+ *
+ * @remark                  The status of the LCD can not be read back through a shift register, so the busy flag can not
+ *                          be polled and the RW output should be tied low (or mapped to an unused output)
+ *
+ * @remark                  The SPI bus is locked for the transfer of each byte, so other devices on the bus (with their
+ *                          own chip selects) can be used in between
+ *
+ * @example                 To drive a module wired to a shift register on SPI1
+ * @code
+ * HD44780ShiftRegisterBus bus(D11, D13, D10);
+ * HD44780LCD lcd(bus, HD44780LCD::GEOMETRY_20X4);
+ *
+ * lcd.initialize();
+ * lcd.printf("Hello World!");
+ * @endcode
+ *
+ */
+class HD44780ShiftRegisterBus : public HD44780Bus {
+
+    /** Default frequency of the SPI bus (well within the limits of the 74HC595 at 3.3V) */
+    static constexpr int        DEFAULT_FREQUENCY   = 1000000;
+    /** Number of bytes shifted out to transfer a nibble (setup, EN high, EN low) */
+    static constexpr uint32_t   NIBBLE_OUTPUTS      = 3;
+
+    /** SPI bus to which the shift register is connected (MISO is not used) */
+    SPI         spi;
+    /** Pin connected to the storage register clock (RCLK) of the shift register */
+    DigitalOut  latch;
+
+    /** Mapping of the outputs of the shift register to the pins of the LCD */
+    HD44780LCD::PinMap  pins;
+    /** Whether the backlight is switched on */
+    bool        backlightOn {false};
+    /** Outputs last latched into the shift register */
+    uint8_t     lastOutput {0};
+
+    /**
+     * @brief               Shift out a sequence of outputs, latching each of them in turn
+     *
+     * @param outputs       Outputs to latch
+     * @param len           Number of outputs
+     */
+    void            shift_out(const uint8_t *outputs, uint32_t len);
+
+    /**
+     * @brief               Encode a nibble into the outputs that transfer it to the LCD
+     *
+     * @param outputs       Buffer of at least ```NIBBLE_OUTPUTS``` bytes to store the outputs in
+     * @param nibble        Nibble to transfer
+     * @param isData        Whether the nibble is part of a character or an instruction
+     */
+    void            encode_nibble(uint8_t *outputs, uint8_t nibble, uint8_t isData) const;
+
+protected:
+
+    /**
+     * @brief               Always 0, since the status of the LCD can not be read through the shift register
+     *
+     * @return uint8_t      0
+     */
+    uint8_t         poll_status() override;
+
+public:
+
+    HD44780ShiftRegisterBus() = delete;
+
+    /**
+     * @brief               Construct a new HD44780ShiftRegisterBus object
+     *
+     * @param mosi          Pin connected to the serial input (SER) of the shift register
+     * @param sclk          Pin connected to the shift register clock (SRCLK) of the shift register
+     * @param latch         Pin connected to the storage register clock (RCLK) of the shift register
+     * @param pinMap        Mapping of the outputs of the shift register to the pins of the LCD
+     * @param frequency     Frequency of the SPI bus in Hz
+     *
+     */
+    HD44780ShiftRegisterBus(PinName mosi, PinName sclk, PinName latch,
+            const HD44780LCD::PinMap &pinMap = HD44780LCD::DEFAULT_PIN_MAP, int frequency = DEFAULT_FREQUENCY);
+
+    void            send_byte(uint8_t byte, uint8_t isData, std::chrono::microseconds execTime = EXEC_TIME) override;
+
+    void            send_nibble(uint8_t nibble, uint8_t isData, std::chrono::microseconds execTime = EXEC_TIME) override;
+
+    void            enable_backlight() override;
+
+    void            disable_backlight() override;
+
+    void            toggle_backlight() override;
+
+    bool            is_backlight_on() const override;
+
+    bool            is_readable() const override;
+};
+
+#endif //__HD44780SHIFTREGISTERBUS_H__
@@ -0,0 +1,460 @@
+/**
+ * @file                    HD44780Widgets.cpp
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Widgets (bar graphs, big digits and numeric fields) for HD44780 LCDs, updated by writing only
+ *                          the cells that change
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#include "HD44780Widgets.h"
+
+/** value denoting that the character in a cell is not known */
+constexpr uint16_t  NO_CODE             = 0xffff;
+
+/** number of columns of pixels in a cell */
+constexpr uint32_t  CELL_PIXELS         = 5;
+
+/** powers of 10 by which numbers with 0 to 6 digits after the decimal point are scaled */
+constexpr uint32_t  DECIMAL_SCALES[7]   = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+/** largest magnitude of a number shown with digits after the decimal point (scaled by up to 10^6 in double precision,
+    which holds the product exactly, the result fits in 64 bits) */
+constexpr float     MAX_MAGNITUDE       = 1e12f;
+
+/** glyphs of cells with 1 to 5 filled columns of pixels */
+constexpr uint8_t   BAR_GLYPHS[5][8]    = {
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10},
+    {0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18},
+    {0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c},
+    {0x1e, 0x1e, 0x1e, 0x1e, 0x1e, 0x1e, 0x1e, 0x1e},
+    {0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f},
+};
+
+/** glyphs of the upper bar, lower bar and both bars of the big digits */
+constexpr uint8_t   DIGIT_GLYPHS[3][8]  = {
+    {0x1f, 0x1f, 0x1f, 0x00, 0x00, 0x00, 0x00, 0x00},
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x1f, 0x1f},
+    {0x1f, 0x1f, 0x1f, 0x00, 0x00, 0x1f, 0x1f, 0x1f},
+};
+
+/** segment of a big digit that is blank */
+constexpr uint8_t   SEG_BLANK           = 0;
+/** segment of a big digit that shows the upper bar */
+constexpr uint8_t   SEG_UPPER           = 1;
+/** segment of a big digit that shows the lower bar */
+constexpr uint8_t   SEG_LOWER           = 2;
+/** segment of a big digit that shows both bars */
+constexpr uint8_t   SEG_BOTH            = 3;
+/** segment of a big digit that is a full block */
+constexpr uint8_t   SEG_FULL            = 4;
+
+/** segments of the upper and lower rows of the digits 0 to 9, the minus sign and the blank */
+constexpr uint8_t   DIGIT_SEGMENTS[12][2][3] = {
+    {{SEG_FULL,  SEG_UPPER, SEG_FULL},  {SEG_FULL,  SEG_LOWER, SEG_FULL}},
+    {{SEG_UPPER, SEG_FULL,  SEG_BLANK}, {SEG_LOWER, SEG_FULL,  SEG_LOWER}},
+    {{SEG_BOTH,  SEG_BOTH,  SEG_FULL},  {SEG_FULL,  SEG_LOWER, SEG_LOWER}},
+    {{SEG_BOTH,  SEG_BOTH,  SEG_FULL},  {SEG_LOWER, SEG_LOWER, SEG_FULL}},
+    {{SEG_FULL,  SEG_LOWER, SEG_FULL},  {SEG_BLANK, SEG_BLANK, SEG_FULL}},
+    {{SEG_FULL,  SEG_BOTH,  SEG_BOTH},  {SEG_LOWER, SEG_LOWER, SEG_FULL}},
+    {{SEG_FULL,  SEG_BOTH,  SEG_BOTH},  {SEG_FULL,  SEG_LOWER, SEG_FULL}},
+    {{SEG_UPPER, SEG_UPPER, SEG_FULL},  {SEG_BLANK, SEG_BLANK, SEG_FULL}},
+    {{SEG_FULL,  SEG_BOTH,  SEG_FULL},  {SEG_FULL,  SEG_LOWER, SEG_FULL}},
+    {{SEG_FULL,  SEG_BOTH,  SEG_FULL},  {SEG_LOWER, SEG_LOWER, SEG_FULL}},
+    {{SEG_LOWER, SEG_LOWER, SEG_LOWER}, {SEG_BLANK, SEG_BLANK, SEG_BLANK}},
+    {{SEG_BLANK, SEG_BLANK, SEG_BLANK}, {SEG_BLANK, SEG_BLANK, SEG_BLANK}},
+};
+
+/** index of the minus sign in ```DIGIT_SEGMENTS``` */
+constexpr uint32_t  DIGIT_MINUS         = 10;
+/** index of the blank in ```DIGIT_SEGMENTS``` */
+constexpr uint32_t  DIGIT_BLANK         = 11;
+
+/**
+ * @brief                   Write the characters of a row of a widget that differ from the ones last written, one run of
+ *                          consecutive changed cells at a time
+ *
+ * @param lcd               LCD on which the widget is drawn
+ * @param r                 Row of the cells
+ * @param c                 Column of the first cell
+ * @param codes             Characters to show in the cells
+ * @param shown             Characters last written to the cells (updated)
+ * @param len               Number of cells
+ * @return true             If any cell was written (the cursor was moved)
+ * @return false            Otherwise
+ */
+static bool
+write_changes(HD44780LCD &lcd, uint32_t r, uint32_t c, const uint8_t *codes, uint16_t *shown, uint32_t len) {
+
+    bool moved = false;
+
+    for (uint32_t idx = 0; idx < len; ) {
+
+        if (shown[idx] == codes[idx]) {
+            ++idx;
+            continue;
+        }
+
+        uint32_t run = 0;
+        while ((idx + run) < len && shown[idx + run] != codes[idx + run]) {
+
+            shown[idx + run] = codes[idx + run];
+            ++run;
+        }
+
+        lcd.set_cursor_pos(r, c + idx);
+        lcd.send_buffer(&codes[idx], run);
+
+        idx += run;
+        moved = true;
+    }
+
+    return moved;
+}
+
+// Constructors
+
+HD44780BarGraph::HD44780BarGraph(HD44780LCD &lcd, uint32_t r, uint32_t c, uint32_t width, uint8_t firstSlot)
+        : lcd {lcd}
+        , row {r}
+        , col {c}
+        , firstSlot {firstSlot}
+{
+    const uint32_t cols = lcd.get_col_count();
+    const uint32_t limit = (c < cols) ? (cols - c) : 0;
+
+    this->width = (width < limit) ? width : limit;
+    if (this->width > MAX_WIDTH) {
+        this->width = MAX_WIDTH;
+    }
+
+    invalidate();
+}
+
+HD44780BigDigits::HD44780BigDigits(HD44780LCD &lcd, uint32_t r, uint32_t c, uint32_t digitCount, uint8_t firstSlot,
+        uint8_t fullBlock)
+        : lcd {lcd}
+        , row {r}
+        , col {c}
+        , firstSlot {firstSlot}
+        , fullBlock {fullBlock}
+{
+    const uint32_t cols = lcd.get_col_count();
+    const uint32_t limit = (c < cols) ? ((cols - c + 1) / DIGIT_PITCH) : 0;
+
+    this->digitCount = (digitCount < limit) ? digitCount : limit;
+    if (this->digitCount > MAX_DIGITS) {
+        this->digitCount = MAX_DIGITS;
+    }
+
+    // both rows of the digits must be on the display
+    if ((r + 1) >= lcd.get_row_count()) {
+        this->digitCount = 0;
+    }
+
+    invalidate();
+}
+
+HD44780Field::HD44780Field(HD44780LCD &lcd, uint32_t r, uint32_t c, uint32_t width)
+        : lcd {lcd}
+        , row {r}
+        , col {c}
+{
+    const uint32_t cols = lcd.get_col_count();
+    const uint32_t limit = (c < cols && r < lcd.get_row_count()) ? (cols - c) : 0;
+
+    this->width = (width < limit) ? width : limit;
+    if (this->width > MAX_WIDTH) {
+        this->width = MAX_WIDTH;
+    }
+}
+
+// public methods
+
+void
+HD44780BarGraph::load_glyphs() {
+    lcd.load_glyphs(firstSlot, GLYPH_COUNT, BAR_GLYPHS);
+}
+
+void
+HD44780BarGraph::set_value(uint32_t value, uint32_t max) {
+
+    if (max == 0) {
+        return;
+    }
+
+    if (value > max) {
+        value = max;
+    }
+
+    set_pixels(((uint64_t)value * width * CELL_PIXELS) / max);
+}
+
+void
+HD44780BarGraph::set_pixels(uint32_t pixels) {
+
+    uint8_t codes[MAX_WIDTH];
+
+    for (uint32_t i = 0; i < width; ++i) {
+
+        uint32_t filled = (pixels > (i * CELL_PIXELS)) ? (pixels - (i * CELL_PIXELS)) : 0;
+
+        codes[i] = (filled == 0)
+                ? ' '
+                : (firstSlot + ((filled < CELL_PIXELS) ? filled : CELL_PIXELS) - 1);
+    }
+
+    HD44780LCD::Transaction transaction(lcd);
+
+    const auto r = lcd.get_cursor_row();
+    const auto c = lcd.get_cursor_col();
+
+    if (write_changes(lcd, row, col, codes, shown, width)) {
+        lcd.set_cursor_pos(r, c);
+    }
+}
+
+void
+HD44780BarGraph::invalidate() {
+
+    for (auto &code : shown) {
+        code = NO_CODE;
+    }
+}
+
+uint8_t
+HD44780BarGraph::get_full_block() const {
+    return firstSlot + GLYPH_COUNT - 1;
+}
+
+void
+HD44780BigDigits::load_glyphs() {
+    lcd.load_glyphs(firstSlot, GLYPH_COUNT, DIGIT_GLYPHS);
+}
+
+bool
+HD44780BigDigits::set_value(int32_t value) {
+
+    char text[MAX_DIGITS + 1];
+
+    auto len = snprintf(text, sizeof(text), "%*ld", (int)digitCount, (long)value);
+    if (len < 0 || (uint32_t)len > digitCount) {
+        return false;
+    }
+
+    set_text(text);
+    return true;
+}
+
+void
+HD44780BigDigits::set_text(const char *text) {
+
+    const uint32_t width = get_width();
+
+    uint8_t codes[2][MAX_DIGITS * DIGIT_PITCH];
+
+    for (uint32_t d = 0; d < digitCount; ++d) {
+
+        uint32_t digit = DIGIT_BLANK;
+
+        if (*text >= '0' && *text <= '9') {
+            digit = *text - '0';
+        }
+        else if (*text == '-') {
+            digit = DIGIT_MINUS;
+        }
+
+        if (*text != '\0') {
+            ++text;
+        }
+
+        for (uint32_t half = 0; half < 2; ++half) {
+            for (uint32_t i = 0; i < 3; ++i) {
+
+                auto segment = DIGIT_SEGMENTS[digit][half][i];
+
+                codes[half][(d * DIGIT_PITCH) + i] = (segment == SEG_BLANK)
+                        ? ' '
+                        : (segment == SEG_FULL)
+                        ? fullBlock
+                        : (firstSlot + segment - SEG_UPPER);
+            }
+
+            // the column between two digits is always blank
+            if ((d * DIGIT_PITCH) + 3 < width) {
+                codes[half][(d * DIGIT_PITCH) + 3] = ' ';
+            }
+        }
+    }
+
+    HD44780LCD::Transaction transaction(lcd);
+
+    const auto r = lcd.get_cursor_row();
+    const auto c = lcd.get_cursor_col();
+
+    bool moved = write_changes(lcd, row, col, codes[0], shown[0], width);
+    moved |= write_changes(lcd, row + 1, col, codes[1], shown[1], width);
+
+    if (moved) {
+        lcd.set_cursor_pos(r, c);
+    }
+}
+
+void
+HD44780BigDigits::invalidate() {
+
+    for (auto &half : shown) {
+        for (auto &code : half) {
+            code = NO_CODE;
+        }
+    }
+}
+
+// private methods
+
+uint32_t
+HD44780BigDigits::get_width() const {
+
+    return (digitCount == 0)
+    ? 0
+    : ((digitCount * DIGIT_PITCH) - 1);
+}
+
+bool
+HD44780Field::set_value(int32_t value) {
+
+    uint8_t codes[MAX_WIDTH];
+
+    const bool negative = value < 0;
+    const uint64_t magnitude = negative ? -(int64_t)value : value;
+
+    if (!format(codes, magnitude, 0, negative)) {
+        return false;
+    }
+
+    show(codes);
+    return true;
+}
+
+bool
+HD44780Field::set_value(float value, uint32_t precision) {
+
+    uint8_t codes[MAX_WIDTH];
+
+    // NaN fails the comparison as well, so that only finite numbers are shown
+    const float absolute = (value < 0) ? -value : value;
+    if (precision > MAX_PRECISION || !(absolute < MAX_MAGNITUDE)) {
+        return false;
+    }
+
+    // a float has at most 24 significant bits and the scale at most 20, so their product is exact in double precision,
+    // and so is its fractional part, which rounds the last digit half up
+    const double scaled = (double)absolute * DECIMAL_SCALES[precision];
+    uint64_t magnitude = (uint64_t)scaled;
+    if ((scaled - magnitude) >= 0.5) {
+        ++magnitude;
+    }
+
+    // values that round to zero are shown without a minus sign
+    if (!format(codes, magnitude, precision, (value < 0) && (magnitude != 0))) {
+        return false;
+    }
+
+    show(codes);
+    return true;
+}
+
+void
+HD44780Field::set_text(const char *text) {
+
+    uint8_t codes[MAX_WIDTH];
+
+    for (uint32_t i = 0; i < width; ++i) {
+
+        codes[i] = (*text != '\0') ? *text : ' ';
+
+        if (*text != '\0') {
+            ++text;
+        }
+    }
+
+    show(codes);
+}
+
+// private methods
+
+bool
+HD44780Field::format(uint8_t *codes, uint64_t magnitude, uint32_t precision, bool negative) const {
+
+    uint32_t pos = width;
+
+    // digits are produced from the least significant one, with at least one before the decimal point
+    for (uint32_t digits = 0; digits <= precision || magnitude != 0; ++digits) {
+
+        if (precision != 0 && digits == precision) {
+
+            if (pos == 0) {
+                return false;
+            }
+            codes[--pos] = '.';
+        }
+
+        if (pos == 0) {
+            return false;
+        }
+        codes[--pos] = '0' + (magnitude % 10);
+        magnitude /= 10;
+    }
+
+    if (negative) {
+
+        if (pos == 0) {
+            return false;
+        }
+        codes[--pos] = '-';
+    }
+
+    while (pos != 0) {
+        codes[--pos] = ' ';
+    }
+
+    return true;
+}
+
+void
+HD44780Field::show(const uint8_t *codes) {
+
+    HD44780LCD::Transaction transaction(lcd);
+
+    const auto r = lcd.get_cursor_row();
+    const auto c = lcd.get_cursor_col();
+
+    bool moved = false;
+
+    // the cells are compared with the frame kept by the LCD, so that characters written over the field by other means
+    // are replaced on the next update as well
+    for (uint32_t idx = 0; idx < width; ) {
+
+        if (lcd.get_char_at(row, col + idx) == codes[idx]) {
+            ++idx;
+            continue;
+        }
+
+        uint32_t run = 1;
+        while ((idx + run) < width && lcd.get_char_at(row, col + idx + run) != codes[idx + run]) {
+            ++run;
+        }
+
+        lcd.set_cursor_pos(row, col + idx);
+        lcd.send_buffer(&codes[idx], run);
+
+        idx += run;
+        moved = true;
+    }
+
+    if (moved) {
+        lcd.set_cursor_pos(r, c);
+    }
+}
@@ -0,0 +1,376 @@
+/**
+ * @file                    HD44780Widgets.h
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Widgets (bar graphs, big digits and numeric fields) for HD44780 LCDs, updated by writing only
+ *                          the cells that change
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#ifndef __HD44780WIDGETS_H__
+#define __HD44780WIDGETS_H__
+
+#include "HD44780LCD.h"
+
+/**
+ * @brief                   Class that draws a horizontal bar graph in a row of an LCD, with a resolution of one column of
+ *                          pixels (5 per cell)
+ *
+ * @remark                  The 5 glyphs of the partially (1 to 4 columns) and completely filled cells are uploaded once
+ *                          into consecutive CGRAM slots, after which each update only writes the cells that change (a bar
+ *                          that moves by one pixel costs one or two characters)
+ *
+ * @remark                  Cells are written with the cursor auto-increment entry mode in mind, the display auto-shift
+ *                          entry modes would scroll the display on each write
+ *
+ * @example                 To draw a 10 cell wide bar in the second row
+ * @code
+ * HD44780BarGraph bar(lcd, 1, 0, 10);
+ *
+ * bar.load_glyphs();
+ * bar.set_value(adc.read_u16(), 0xffff);
+ * @endcode
+ *
+ */
+class HD44780BarGraph {
+
+    /** Maximum number of cells in a bar (a line of the DDRAM in two-line mode) */
+    static constexpr uint32_t   MAX_WIDTH   = 40;
+    /** Number of glyphs used by the bar (1 to 5 filled columns) */
+    static constexpr uint32_t   GLYPH_COUNT = 5;
+
+    /** LCD on which the bar is drawn */
+    HD44780LCD      &lcd;
+
+    /** Row in which the bar is drawn */
+    uint32_t        row;
+    /** Column of the first cell of the bar */
+    uint32_t        col;
+    /** Number of cells in the bar */
+    uint32_t        width;
+    /** CGRAM slot holding the glyph of a cell with one filled column (the rest follow it) */
+    uint8_t         firstSlot;
+
+    /** Characters last written to the cells of the bar (```0xffff``` if unknown) */
+    uint16_t        shown[MAX_WIDTH];
+
+public:
+
+    HD44780BarGraph() = delete;
+
+    HD44780BarGraph(const HD44780BarGraph &) = delete;
+
+    /**
+     * @brief               Construct a new HD44780BarGraph object
+     *
+     * @param lcd           LCD on which the bar is drawn
+     * @param r             Row in which the bar is drawn
+     * @param c             Column of the first cell of the bar
+     * @param width         Number of cells in the bar (truncated at the end of the row)
+     * @param firstSlot     First of the 5 consecutive CGRAM slots used by the bar (0 to 3)
+     *
+     */
+    HD44780BarGraph(HD44780LCD &lcd, uint32_t r, uint32_t c, uint32_t width, uint8_t firstSlot = 0);
+
+    /**
+     * @brief               Upload the glyphs of the bar into the CGRAM of the LCD
+     *
+     * @remark              Must be called once after the LCD is initialized (which does not preserve the CGRAM)
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     */
+    void            load_glyphs();
+
+    /**
+     * @brief               Draw the bar filled in proportion to a value
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     * @param value         Value to draw (clamped to ```max```)
+     * @param max           Value at which the bar is completely filled
+     */
+    void            set_value(uint32_t value, uint32_t max);
+
+    /**
+     * @brief               Draw the bar filled up to a number of columns of pixels
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     * @param pixels        Number of filled columns of pixels (clamped to 5 times the width)
+     */
+    void            set_pixels(uint32_t pixels);
+
+    /**
+     * @brief               Forget the contents of the cells, such that all of them are written on the next update
+     *
+     * @remark              Must be called after the cells are overwritten directly on the LCD
+     *
+     * @attention           This method can be called from ISR context
+     *
+     */
+    void            invalidate();
+
+    /**
+     * @brief               Get the CGRAM slot of the glyph of a completely filled cell (which can also be used as the
+     *                      full block of ```HD44780BigDigits```)
+     *
+     * @attention           This method can be called from ISR context
+     *
+     * @return uint8_t      Slot (character code) of the completely filled cell
+     */
+    uint8_t         get_full_block() const;
+};
+
+/**
+ * @brief                   Class that draws numbers in large digits (3 columns wide and 2 rows tall, separated by a blank
+ *                          column) on an LCD
+ *
+ * @remark                  The digits are made of 3 glyphs (upper bar, lower bar and both bars) uploaded once into
+ *                          consecutive CGRAM slots and a full block, after which each update only writes the cells that
+ *                          change
+ *
+ * @remark                  The full block is character ```0xff``` of the A00 ROM by default, modules with other ROMs can
+ *                          use a custom character instead (such as the one of ```HD44780BarGraph::get_full_block()```)
+ *
+ * @remark                  Cells are written with the cursor auto-increment entry mode in mind, the display auto-shift
+ *                          entry modes would scroll the display on each write
+ *
+ * @example                 To show a 4 digit counter on a 16x2 module
+ * @code
+ * HD44780BigDigits digits(lcd, 0, 0, 4);
+ *
+ * digits.load_glyphs();
+ * digits.set_value(count);
+ * @endcode
+ *
+ */
+class HD44780BigDigits {
+
+    /** Maximum number of digits (that fit in a line of the DDRAM in two-line mode) */
+    static constexpr uint32_t   MAX_DIGITS  = 10;
+    /** Number of columns taken by each digit (including the blank column after it) */
+    static constexpr uint32_t   DIGIT_PITCH = 4;
+    /** Number of glyphs used by the digits */
+    static constexpr uint32_t   GLYPH_COUNT = 3;
+
+    /** LCD on which the digits are drawn */
+    HD44780LCD      &lcd;
+
+    /** Upper row of the digits */
+    uint32_t        row;
+    /** Column of the first digit */
+    uint32_t        col;
+    /** Number of digits */
+    uint32_t        digitCount;
+    /** CGRAM slot holding the upper bar (followed by the lower bar and both bars) */
+    uint8_t         firstSlot;
+    /** Character drawn as a full block */
+    uint8_t         fullBlock;
+
+    /** Characters last written to the cells of each row of the digits (```0xffff``` if unknown) */
+    uint16_t        shown[2][MAX_DIGITS * DIGIT_PITCH];
+
+    /**
+     * @brief               Get the number of cells taken by the digits in each row
+     *
+     * @return uint32_t     Number of cells (without the blank column after the last digit)
+     */
+    uint32_t        get_width() const;
+
+public:
+
+    HD44780BigDigits() = delete;
+
+    HD44780BigDigits(const HD44780BigDigits &) = delete;
+
+    /**
+     * @brief               Construct a new HD44780BigDigits object
+     *
+     * @param lcd           LCD on which the digits are drawn
+     * @param r             Upper row of the digits (the one below it must exist)
+     * @param c             Column of the first digit
+     * @param digitCount    Number of digits (up to 10, truncated at the end of the row)
+     * @param firstSlot     First of the 3 consecutive CGRAM slots used by the digits (0 to 5)
+     * @param fullBlock     Character drawn as a full block
+     *
+     */
+    HD44780BigDigits(HD44780LCD &lcd, uint32_t r, uint32_t c, uint32_t digitCount, uint8_t firstSlot = 5,
+            uint8_t fullBlock = 0xff);
+
+    /**
+     * @brief               Upload the glyphs of the digits into the CGRAM of the LCD
+     *
+     * @remark              Must be called once after the LCD is initialized (which does not preserve the CGRAM)
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     */
+    void            load_glyphs();
+
+    /**
+     * @brief               Draw a number, aligned to the right
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     * @param value         Number to draw (negative numbers are preceded by a minus sign)
+     * @return true         If the number was drawn
+     * @return false        If it has more digits than can be drawn (nothing is drawn)
+     */
+    bool            set_value(int32_t value);
+
+    /**
+     * @brief               Draw a string of digits, aligned to the left
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     * @param text          Characters to draw (```'0'``` to ```'9'``` and ```'-'```, others are drawn blank), truncated
+     *                      at the number of digits and padded with blanks
+     */
+    void            set_text(const char *text);
+
+    /**
+     * @brief               Forget the contents of the cells, such that all of them are written on the next update
+     *
+     * @remark              Must be called after the cells are overwritten directly on the LCD
+     *
+     * @attention           This method can be called from ISR context
+     *
+     */
+    void            invalidate();
+};
+
+/**
+ * @brief                   Class that shows a number (or short text) in a fixed span of cells of a row of an LCD,
+ *                          formatted without stdio and updated by writing only the characters that change
+ *
+ * @remark                  A counter that ticks from 1234 to 1235 costs a single cursor movement and character, and a
+ *                          value that does not change costs nothing, so many fields can be refreshed at a high rate
+ *
+ * @remark                  Cells are written with the cursor auto-increment entry mode in mind, the display auto-shift
+ *                          entry modes would scroll the display on each write
+ *
+ * @example                 To show a voltage and a counter on a 16x2 module
+ * @code
+ * HD44780Field volts(lcd, 0, 8, 6);
+ * HD44780Field count(lcd, 1, 8, 8);
+ *
+ * lcd.printf_at(0, 0, "Volts:");
+ * lcd.printf_at(1, 0, "Count:");
+ *
+ * while (true) {
+ *     volts.set_value(adc.read() * 3.3f, 2);
+ *     count.set_value(counter);
+ *     ThisThread::sleep_for(50ms);
+ * }
+ * @endcode
+ *
+ */
+class HD44780Field {
+
+    /** Maximum number of cells in a field (a line of the DDRAM in two-line mode) */
+    static constexpr uint32_t   MAX_WIDTH       = 40;
+    /** Maximum number of digits after the decimal point */
+    static constexpr uint32_t   MAX_PRECISION   = 6;
+
+    /** LCD on which the field is shown */
+    HD44780LCD      &lcd;
+
+    /** Row in which the field is shown */
+    uint32_t        row;
+    /** Column of the first cell of the field */
+    uint32_t        col;
+    /** Number of cells in the field */
+    uint32_t        width;
+
+    /**
+     * @brief               Format a number into the cells of the field, aligned to the right and padded with blanks
+     *
+     * @param codes         Buffer of at least ```width``` characters to format into
+     * @param magnitude     Absolute value of the number, scaled by 10 to the power of ```precision```
+     * @param precision     Number of digits after the decimal point
+     * @param negative      Whether the number is preceded by a minus sign
+     * @return true         If the number fits in the field
+     * @return false        Otherwise
+     */
+    bool            format(uint8_t *codes, uint64_t magnitude, uint32_t precision, bool negative) const;
+
+    /**
+     * @brief               Write the characters of the field that differ from the ones on the display (as kept in the
+     *                      frame of the LCD), one run of consecutive changed cells at a time
+     *
+     * @param codes         Characters to show in the cells of the field
+     */
+    void            show(const uint8_t *codes);
+
+public:
+
+    HD44780Field() = delete;
+
+    HD44780Field(const HD44780Field &) = delete;
+
+    /**
+     * @brief               Construct a new HD44780Field object
+     *
+     * @param lcd           LCD on which the field is shown
+     * @param r             Row in which the field is shown
+     * @param c             Column of the first cell of the field
+     * @param width         Number of cells in the field (up to 40, truncated at the end of the row)
+     *
+     */
+    HD44780Field(HD44780LCD &lcd, uint32_t r, uint32_t c, uint32_t width);
+
+    /**
+     * @brief               Show an integer, aligned to the right
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     * @param value         Number to show (negative numbers are preceded by a minus sign)
+     * @return true         If the number was shown
+     * @return false        If it does not fit in the field (the field is left unchanged)
+     */
+    bool            set_value(int32_t value);
+
+    /**
+     * @brief               Show a number with a fixed number of digits after the decimal point, aligned to the right
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @remark              The number is rounded to the nearest representable value (half up), the scaling is done
+     *                      in double precision so that the digits shown are exact for every float that fits
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     * @param value         Number to show (negative numbers are preceded by a minus sign)
+     * @param precision     Number of digits after the decimal point (up to 6)
+     * @return true         If the number was shown
+     * @return false        If it is not finite, is too large, has too many digits after the decimal point or does
+     *                      not fit in the field (the field is left unchanged)
+     */
+    bool            set_value(float value, uint32_t precision);
+
+    /**
+     * @brief               Show text, aligned to the left
+     *
+     * @remark              This method does not alter the cursor position
+     *
+     * @attention           Can not call this method from ISR context
+     *
+     * @param text          Characters to show (sent as they are), truncated at the width and padded with blanks
+     */
+    void            set_text(const char *text);
+};
+
+#endif //__HD44780WIDGETS_H__
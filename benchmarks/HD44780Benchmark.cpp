@@ -0,0 +1,228 @@
+/**
+ * @file                    HD44780Benchmark.cpp
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   On-target benchmark of the HD44780LCD library, measuring the throughput and latency of common
+ *                          operations for each transport and timing mode, and printing them to the console
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#include "mbed.h"
+
+#include "HD44780LCD.h"
+#include "HD44780ParallelBus.h"
+#include "HD44780ShiftRegisterBus.h"
+
+#ifndef HD44780_BENCHMARK_I2C_SDA
+/** Pin connected to the SDA pin of the PC8574 backpack */
+#define HD44780_BENCHMARK_I2C_SDA       I2C_SDA
+#endif
+
+#ifndef HD44780_BENCHMARK_I2C_SCL
+/** Pin connected to the SCL pin of the PC8574 backpack */
+#define HD44780_BENCHMARK_I2C_SCL       I2C_SCL
+#endif
+
+// define HD44780_BENCHMARK_PARALLEL_PINS to the pins of a directly wired module to benchmark the parallel transport, as
+// the arguments of one of the constructors of HD44780ParallelBus (such as D8, D9, D4, D5, D6, D7, D10)
+
+// define HD44780_BENCHMARK_SHIFT_REGISTER_PINS to the pins of a module wired to a 74HC595 to benchmark the shift register
+// transport, as the arguments of the constructor of HD44780ShiftRegisterBus (such as D11, D13, D10)
+
+/** Number of times each measurement is repeated (the average is reported) */
+static constexpr uint32_t   REPEAT_COUNT    = 16;
+
+/** Pattern uploaded into the CGRAM while measuring ```create_custom_char()``` */
+static constexpr uint8_t    GLYPH[8]        = {0x00, 0x0a, 0x0a, 0x00, 0x11, 0x0e, 0x00, 0x00};
+
+/** Two screens of text that differ in every cell, so that diffing never skips a write */
+static const char           *const SCREENS[2] = {
+    "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz!@#$%^&*()-=_+[]{};:,.<>/?",
+    "zyxwvutsrqponmlkjihgfedcbaZYXWVUTSRQPONMLKJIHGFEDCBA9876543210?/><.,:;}{][+_=-)(*&^%$#@!"
+};
+
+/**
+ * @brief                   Timing modes benchmarked on each transport
+ *
+ */
+enum class Mode {
+
+    /** every command is sent immediately, waiting out the datasheet execution time */
+    DIRECT,
+    /** every command is sent immediately, polling the busy flag for long instructions */
+    POLLED,
+    /** characters are collected in RAM and only the changed cells are written on flushing */
+    BUFFERED,
+    /** commands are queued and sent by the driver thread */
+    ASYNC,
+};
+
+/** Names of the timing modes (in the order of ```Mode```) */
+static const char           *const MODE_NAMES[] = {"direct", "polled", "buffered", "async"};
+
+/** Timer used for all measurements */
+static Timer                timer;
+
+/**
+ * @brief                   Measure the average time taken by an operation, including the time taken to send all of it
+ *                          to the LCD (in asynchronous mode)
+ *
+ * @param lcd               LCD the operation is performed on
+ * @param op                Operation performed, called with the index of the repetition
+ * @return uint32_t         Average time in microseconds
+ */
+template <typename Op>
+static uint32_t
+measure(HD44780LCD &lcd, Op op) {
+
+    lcd.sync();
+
+    const auto start = timer.elapsed_time();
+
+    for (uint32_t i = 0; i < REPEAT_COUNT; ++i) {
+        op(i);
+    }
+    lcd.sync();
+
+    return (timer.elapsed_time() - start).count() / REPEAT_COUNT;
+}
+
+/**
+ * @brief                   Write a whole screen of text, flushing it if buffering is enabled
+ *
+ * @param lcd               LCD to write to
+ * @param idx               Index of the screen in ```SCREENS``` (modulo 2)
+ */
+static void
+paint(HD44780LCD &lcd, uint32_t idx) {
+
+    const char *text = SCREENS[idx & 1];
+
+    const auto rows = lcd.get_row_count();
+    const auto cols = lcd.get_col_count();
+
+    for (uint32_t r = 0; r < rows; ++r) {
+
+        lcd.set_cursor_pos(r, 0);
+        lcd.send_buffer((const uint8_t *)&text[r * cols], cols);
+    }
+
+    if (lcd.is_buffering_enabled()) {
+        lcd.flush();
+    }
+}
+
+/**
+ * @brief                   Run all measurements on an LCD in every timing mode and print them
+ *
+ * @param name              Name of the transport printed along with the results
+ * @param lcd               LCD to benchmark
+ */
+static void
+run(const char *name, HD44780LCD &lcd) {
+
+    const auto cols = lcd.get_col_count();
+
+    for (auto mode : {Mode::DIRECT, Mode::POLLED, Mode::BUFFERED, Mode::ASYNC}) {
+
+        const auto initStart = timer.elapsed_time();
+        lcd.initialize();
+        const uint32_t initUs = (timer.elapsed_time() - initStart).count();
+
+        switch (mode) {
+        case Mode::DIRECT:
+            break;
+        case Mode::POLLED:
+            lcd.enable_busy_polling();
+            break;
+        case Mode::BUFFERED:
+            lcd.enable_buffering();
+            break;
+        case Mode::ASYNC:
+            lcd.enable_async();
+            break;
+        }
+
+#if HD44780LCD_ENABLE_STATS
+        lcd.reset_stats();
+#endif // HD44780LCD_ENABLE_STATS
+
+        // a row is written per repetition, alternating between the screens so that every cell changes
+        const uint32_t rowUs = measure(lcd, [&lcd, cols](uint32_t i) {
+
+            lcd.set_cursor_pos(0, 0);
+            lcd.send_buffer((const uint8_t *)SCREENS[i & 1], cols);
+
+            if (lcd.is_buffering_enabled()) {
+                lcd.flush();
+            }
+        });
+
+        const uint32_t repaintUs = measure(lcd, [&lcd](uint32_t i) {
+            paint(lcd, i);
+        });
+
+        const uint32_t glyphUs = measure(lcd, [&lcd](uint32_t i) {
+            lcd.create_custom_char(i % 8, GLYPH);
+        });
+
+        printf("%-16s %-8s init %6lu us, %6lu chars/s, repaint %6lu us, custom char %5lu us\n", name,
+                MODE_NAMES[(uint32_t)mode], initUs, (rowUs != 0) ? (cols * 1000000UL) / rowUs : 0, repaintUs,
+                glyphUs);
+
+#if HD44780LCD_ENABLE_STATS
+        const auto stats = lcd.get_stats();
+        printf("%-16s %-8s %lu instructions, %lu data bytes, %lu writes (%lu failed), blocked %llu us (max %lu us)\n",
+                name, MODE_NAMES[(uint32_t)mode], stats.instructions, stats.dataBytes, stats.writes, stats.errors,
+                stats.blockedUs, stats.maxBlockedUs);
+#endif // HD44780LCD_ENABLE_STATS
+
+        lcd.disable_async();
+        lcd.disable_buffering();
+        lcd.disable_busy_polling();
+    }
+}
+
+int
+main() {
+
+    timer.start();
+
+    printf("HD44780LCD benchmark (%lu repetitions per measurement)\n", REPEAT_COUNT);
+
+    {
+        HD44780LCD lcd(HD44780_BENCHMARK_I2C_SDA, HD44780_BENCHMARK_I2C_SCL, HD44780LCD::GEOMETRY_16X2, 100000);
+        run("I2C 100kHz", lcd);
+    }
+
+    {
+        HD44780LCD lcd(HD44780_BENCHMARK_I2C_SDA, HD44780_BENCHMARK_I2C_SCL, HD44780LCD::GEOMETRY_16X2, 400000);
+        run("I2C 400kHz", lcd);
+    }
+
+#ifdef HD44780_BENCHMARK_PARALLEL_PINS
+    {
+        HD44780ParallelBus bus(HD44780_BENCHMARK_PARALLEL_PINS);
+        HD44780LCD lcd(bus);
+
+        run((bus.get_bus_width() == 8) ? "parallel 8-bit" : "parallel 4-bit", lcd);
+    }
+#endif // HD44780_BENCHMARK_PARALLEL_PINS
+
+#ifdef HD44780_BENCHMARK_SHIFT_REGISTER_PINS
+    {
+        HD44780ShiftRegisterBus bus(HD44780_BENCHMARK_SHIFT_REGISTER_PINS);
+        HD44780LCD lcd(bus);
+
+        run("shift register", lcd);
+    }
+#endif // HD44780_BENCHMARK_SHIFT_REGISTER_PINS
+
+    printf("done\n");
+
+    while (true) {
+        ThisThread::sleep_for(1s);
+    }
+}
@@ -0,0 +1,28 @@
+/**
+ * @file                    HD44780Check.h
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Minimal checks for the host tests, which report each failure and let the test go on
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#ifndef __HD44780CHECK_H__
+#define __HD44780CHECK_H__
+
+#include <cstdio>
+
+/** Number of checks that failed so far (returned by the tests as their exit status) */
+inline int checkFailures = 0;
+
+/** Report the expression (and where it is) if it does not hold */
+#define CHECK(expr)                                                                                     \
+    do {                                                                                                \
+        if (!(expr)) {                                                                                  \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr);                    \
+            ++checkFailures;                                                                            \
+        }                                                                                               \
+    } while (0)
+
+#endif //__HD44780CHECK_H__
@@ -0,0 +1,345 @@
+/**
+ * @file                    HD44780Model.h
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Reference model of an HD44780 controller behind a PC8574 backpack, fed with the bytes
+ *                          recorded on the simulated I2C bus
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#ifndef __HD44780MODEL_H__
+#define __HD44780MODEL_H__
+
+#include "mbed.h"
+
+#include <string>
+
+/**
+ * @brief                   Class that decodes the outputs of the PC8574 chip into the strobes seen by an HD44780
+ *                          controller, and executes them on a model of its DDRAM, CGRAM and address counter
+ *
+ * @remark                  A strobe is taken on each falling edge of EN, strobes with RW high are reads and do not change
+ *                          the state of the model
+ *
+ * @remark                  Strobes that arrive while the previous instruction is still executing (by the execution times
+ *                          of the datasheet) are counted as timing violations, and are executed anyway
+ *
+ */
+class HD44780Model {
+
+public:
+
+    /** An instruction (RS low) or character (RS high) executed by the controller */
+    struct Command {
+
+        bool        rs;
+        uint8_t     value;
+
+        bool operator==(const Command &other) const { return rs == other.rs && value == other.value; }
+    };
+
+    /** Size of the DDRAM */
+    static constexpr uint32_t   DDRAM_SIZE      = 0x80;
+    /** Size of the CGRAM */
+    static constexpr uint32_t   CGRAM_SIZE      = 0x40;
+
+    /** Time after power rises before the controller accepts the first strobe (in microseconds) */
+    static constexpr uint64_t   POWER_ON_TIME   = 40000;
+
+private:
+
+    /** Mask of the output connected to RS */
+    uint8_t     rsMask;
+    /** Mask of the output connected to RW */
+    uint8_t     rwMask;
+    /** Mask of the output connected to EN */
+    uint8_t     enMask;
+    /** Index of the output connected to DB4 (DB5 - DB7 follow it) */
+    uint8_t     dataShift;
+
+    /** Number of recorded writes replayed so far */
+    size_t      replayed        {0};
+    /** Outputs of the PC8574 chip before the byte being replayed */
+    uint8_t     outputs         {0xff};
+    /** Higher nibble received in 4-bit mode, waiting for the lower one (negative if none) */
+    int         pendingNibble   {-1};
+    /** Time at which the last instruction finishes executing (in microseconds) */
+    uint64_t    busyUntil       {POWER_ON_TIME};
+    /** Number of instructions executed since power on */
+    uint32_t    instructionCount {0};
+
+    /**
+     * @brief               Normalize an address of the DDRAM after the address counter moved past the end of a line
+     *
+     * @param addr          Address to normalize
+     * @return uint8_t      Address in the DDRAM
+     */
+    uint8_t
+    normalize(int addr) const {
+
+        if (twoLine) {
+
+            if (addr == 0x28) {
+                return 0x40;
+            }
+            if (addr == 0x68) {
+                return 0x00;
+            }
+            if (addr == -1) {
+                return 0x67;
+            }
+            if (addr == 0x3f) {
+                return 0x27;
+            }
+
+            return addr;
+        }
+
+        return (addr < 0) ? 0x4f : ((addr > 0x4f) ? 0x00 : addr);
+    }
+
+    /**
+     * @brief               Execute an instruction or write a character
+     *
+     * @param command       Command to execute
+     * @param at            Time of the strobe that completed the command (in microseconds)
+     */
+    void
+    execute(const Command &command, uint64_t at) {
+
+        log.push_back(command);
+
+        uint64_t execTime = 37;
+
+        if (command.rs) {
+
+            if (cgramSelected) {
+
+                cgram[addrCounter % CGRAM_SIZE] = command.value;
+                addrCounter = (addrCounter + (increment ? 1 : -1)) % CGRAM_SIZE;
+            }
+            else {
+
+                ddram[addrCounter] = command.value;
+                addrCounter = normalize(addrCounter + (increment ? 1 : -1));
+                displayShift += displayAutoShift ? (increment ? 1 : -1) : 0;
+            }
+        }
+        else if (command.value & 0x80) {
+
+            addrCounter = command.value & 0x7f;
+            cgramSelected = false;
+        }
+        else if (command.value & 0x40) {
+
+            addrCounter = command.value & 0x3f;
+            cgramSelected = true;
+        }
+        else if (command.value & 0x20) {
+
+            // the datasheet sequence waits 4.1ms after the first function set and 100us after the second
+            eightBit = (command.value & 0x10) != 0;
+            twoLine = (command.value & 0x08) != 0;
+            execTime = (instructionCount == 0) ? 4100 : ((instructionCount == 1) ? 100 : 37);
+        }
+        else if (command.value & 0x10) {
+
+            const int step = (command.value & 0x04) ? 1 : -1;
+            if (command.value & 0x08) {
+                displayShift += step;
+            }
+            else {
+                addrCounter = normalize(addrCounter + step);
+            }
+        }
+        else if (command.value & 0x08) {
+            displayControl = command.value & 0x07;
+        }
+        else if (command.value & 0x04) {
+
+            increment = (command.value & 0x02) != 0;
+            displayAutoShift = (command.value & 0x01) != 0;
+        }
+        else if (command.value & 0x02) {
+
+            addrCounter = 0;
+            cgramSelected = false;
+            displayShift = 0;
+            execTime = 1520;
+        }
+        else if (command.value & 0x01) {
+
+            memset(ddram, ' ', sizeof(ddram));
+            addrCounter = 0;
+            cgramSelected = false;
+            displayShift = 0;
+            increment = true;
+            execTime = 1520;
+        }
+
+        if (!command.rs) {
+            ++instructionCount;
+        }
+
+        busyUntil = at + execTime;
+    }
+
+    /**
+     * @brief               Take a strobe of the data pins
+     *
+     * @param latched       Outputs of the PC8574 chip while EN was high
+     * @param at            Time of the falling edge of EN (in microseconds)
+     */
+    void
+    strobe(uint8_t latched, uint64_t at) {
+
+        if (latched & rwMask) {
+            return;
+        }
+
+        if (at < busyUntil) {
+            ++timingViolations;
+        }
+
+        const uint8_t nibble = (latched >> dataShift) & 0x0f;
+        const bool rs = (latched & rsMask) != 0;
+
+        ++strobeCount;
+
+        // in 8-bit mode the lower data pins are tied low on a 4-bit module
+        if (eightBit) {
+
+            pendingNibble = -1;
+            execute({rs, (uint8_t)(nibble << 4)}, at);
+        }
+        else if (pendingNibble < 0) {
+            pendingNibble = nibble;
+        }
+        else {
+
+            const uint8_t value = (pendingNibble << 4) | nibble;
+            pendingNibble = -1;
+            execute({rs, value}, at);
+        }
+    }
+
+public:
+
+    /** Contents of the DDRAM */
+    uint8_t                 ddram[DDRAM_SIZE];
+    /** Contents of the CGRAM */
+    uint8_t                 cgram[CGRAM_SIZE];
+
+    /** Address counter */
+    uint8_t                 addrCounter         {0};
+    /** Whether the address counter points into the CGRAM */
+    bool                    cgramSelected       {false};
+    /** Whether the controller takes 8 bits per strobe (as it does after power on) */
+    bool                    eightBit            {true};
+    /** Whether both lines of the DDRAM are used */
+    bool                    twoLine             {false};
+    /** Whether the address counter increments after each character */
+    bool                    increment           {true};
+    /** Whether the display shifts after each character */
+    bool                    displayAutoShift    {false};
+    /** Display, cursor and blink bits of the last display control instruction */
+    uint8_t                 displayControl      {0};
+    /** Number of positions the display is shifted by */
+    int                     displayShift        {0};
+
+    /** Commands executed so far, in order */
+    std::vector<Command>    log;
+    /** Number of strobes taken so far */
+    uint32_t                strobeCount         {0};
+    /** Number of strobes that arrived while the controller was busy */
+    uint32_t                timingViolations    {0};
+
+    /**
+     * @brief               Construct a new HD44780Model object
+     *
+     * @param rs            Index of the output connected to RS
+     * @param rw            Index of the output connected to RW
+     * @param en            Index of the output connected to EN
+     * @param d4            Index of the output connected to DB4 (DB5 - DB7 are connected to the following outputs)
+     */
+    HD44780Model(uint8_t rs = 0, uint8_t rw = 1, uint8_t en = 2, uint8_t d4 = 4)
+            : rsMask(1 << rs)
+            , rwMask(1 << rw)
+            , enMask(1 << en)
+            , dataShift(d4)
+    {
+        memset(ddram, ' ', sizeof(ddram));
+        memset(cgram, 0, sizeof(cgram));
+    }
+
+    /**
+     * @brief               Replay the writes recorded since the last call
+     *
+     */
+    void
+    replay() {
+
+        for (; replayed < MockI2C::writes.size(); ++replayed) {
+
+            const auto &write = MockI2C::writes[replayed];
+
+            // each byte is latched once the 9 clock cycles of the address byte and of itself have passed
+            const uint64_t byteTime = (9 * 1000000ull) / write.frequency;
+            uint64_t at = write.start + byteTime;
+
+            for (const uint8_t byte : write.data) {
+
+                at += byteTime;
+                if ((outputs & enMask) && !(byte & enMask)) {
+                    strobe(outputs, at);
+                }
+
+                outputs = byte;
+            }
+        }
+    }
+
+    /**
+     * @brief               Whether a nibble was received in 4-bit mode and is waiting for the other half
+     *
+     * @return true         If the controller is out of step with the 4-bit transfers
+     * @return false        Otherwise
+     */
+    bool
+    is_nibble_pending() {
+
+        replay();
+        return pendingNibble >= 0;
+    }
+
+    /**
+     * @brief               Get a span of the DDRAM as text
+     *
+     * @param addr          Address of the first character
+     * @param len           Number of characters
+     * @return std::string  Characters in the span
+     */
+    std::string
+    text(uint32_t addr, uint32_t len) {
+
+        replay();
+        return std::string((const char *)&ddram[addr], len);
+    }
+
+    /**
+     * @brief               Get the commands executed since an entry of the log
+     *
+     * @param from          Number of entries of the log to skip
+     * @return std::vector  Commands executed after them
+     */
+    std::vector<Command>
+    commands_since(size_t from) {
+
+        replay();
+        return std::vector<Command>(log.begin() + ((from < log.size()) ? from : log.size()), log.end());
+    }
+};
+
+#endif //__HD44780MODEL_H__
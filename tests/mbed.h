@@ -0,0 +1,527 @@
+/**
+ * @file                    mbed.h
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Host stand-in for the parts of Mbed OS used by the library, which records the bytes written
+ *                          over I2C against a simulated clock, so that the tests can replay them into a model of the LCD
+ *
+ * @remark                  Waiting advances the clock instead of blocking, and an I2C write takes as long as its bytes
+ *                          would at the frequency of the bus
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#ifndef __HD44780_TESTS_MBED_H__
+#define __HD44780_TESTS_MBED_H__
+
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <sys/types.h>
+
+using namespace std::chrono_literals;
+
+#define DEVICE_I2C_ASYNCH               1
+#define DEVICE_PORTINOUT                1
+
+#define MBED_ASSERT(expr)                                                                               \
+    do {                                                                                                \
+        if (!(expr)) {                                                                                  \
+            fprintf(stderr, "%s:%d: assertion failed: %s\n", __FILE__, __LINE__, #expr);                \
+            abort();                                                                                    \
+        }                                                                                               \
+    } while (0)
+
+#define MBED_PRINTF_METHOD(format_idx, first_param_idx)                                                 \
+    __attribute__((__format__(__printf__, format_idx + 1, first_param_idx == 0 ? 0 : first_param_idx + 1)))
+
+#define I2C_EVENT_ERROR                 (1 << 1)
+#define I2C_EVENT_ERROR_NO_SLAVE        (1 << 2)
+#define I2C_EVENT_TRANSFER_COMPLETE     (1 << 3)
+#define I2C_EVENT_TRANSFER_EARLY_NACK   (1 << 4)
+#define I2C_EVENT_ALL                   (I2C_EVENT_ERROR | I2C_EVENT_TRANSFER_COMPLETE | I2C_EVENT_ERROR_NO_SLAVE    \
+                                        | I2C_EVENT_TRANSFER_EARLY_NACK)
+
+enum PinName {
+    NC = -1,
+    PB_6, PB_7, PB_8, PB_9,
+    D0, D1, D2, D3, D4, D5, D6, D7, D8, D9, D10, D11, D12, D13,
+    I2C_SDA = PB_9,
+    I2C_SCL = PB_8,
+};
+
+enum PortName {
+    PortA,
+    PortB,
+    PortC,
+};
+
+/**
+ * @brief                   Record of the traffic on the simulated I2C bus, and the faults to inject into it
+ *
+ */
+struct MockI2C {
+
+    /** A write that reached the PC8574 chip */
+    struct Write {
+
+        /** Time at which the write started (in microseconds) */
+        uint64_t                start;
+        /** Frequency of the bus during the write (in Hz) */
+        int                     frequency;
+        /** Bytes latched onto the outputs of the chip, in order */
+        std::vector<uint8_t>    data;
+    };
+
+    /** Simulated time (in microseconds) */
+    static inline uint64_t              now             = 0;
+
+    /** Writes recorded so far */
+    static inline std::vector<Write>    writes;
+
+    /** Outputs of the PC8574 chip, as last latched (also returned by reads) */
+    static inline uint8_t               outputs         = 0xff;
+
+    /** Number of the following writes that are not acknowledged at all (nothing is latched) */
+    static inline uint32_t              nackCount       = 0;
+    /** Number of the following writes that fail after ```partialLength``` bytes were latched */
+    static inline uint32_t              partialCount    = 0;
+    /** Number of bytes latched by each of the writes that fail partially */
+    static inline uint32_t              partialLength   = 0;
+    /** Number of the following reads that fail */
+    static inline uint32_t              readFailCount   = 0;
+
+    /**
+     * @brief               Forget the recorded traffic and the pending faults, and restart the clock
+     *
+     */
+    static void
+    reset() {
+
+        now = 0;
+        writes.clear();
+        outputs = 0xff;
+        nackCount = 0;
+        partialCount = 0;
+        partialLength = 0;
+        readFailCount = 0;
+    }
+};
+
+inline bool core_util_is_isr_active() { return false; }
+inline void core_util_critical_section_enter() {}
+inline void core_util_critical_section_exit() {}
+
+inline uint32_t core_util_atomic_load_u32(const volatile uint32_t *p) { return *p; }
+inline void core_util_atomic_store_u32(volatile uint32_t *p, uint32_t v) { *p = v; }
+inline bool core_util_atomic_load_bool(const volatile bool *p) { return *p; }
+inline void core_util_atomic_store_bool(volatile bool *p, bool v) { *p = v; }
+
+inline bool
+core_util_atomic_exchange_bool(volatile bool *p, bool v) {
+
+    const bool old = *p;
+    *p = v;
+    return old;
+}
+
+inline void wait_us(int us) { MockI2C::now += us; }
+inline void wait_ns(unsigned ns) { (void)ns; }
+
+namespace mbed {
+
+template <typename F>
+class Callback;
+
+template <typename R, typename... A>
+class Callback<R(A...)> {
+
+    std::function<R(A...)> fn;
+
+public:
+
+    Callback() = default;
+    Callback(std::nullptr_t) {}
+    Callback(R (*f)(A...)) : fn(f) {}
+
+    template <typename T>
+    Callback(T *obj, R (T::*method)(A...)) : fn([obj, method](A... args) { return (obj->*method)(args...); }) {}
+
+    template <typename L, typename = decltype(std::declval<L>()(std::declval<A>()...))>
+    Callback(L lambda) : fn(lambda) {}
+
+    R operator()(A... args) const { return fn(args...); }
+    R call(A... args) const { return fn(args...); }
+    explicit operator bool() const { return (bool)fn; }
+};
+
+template <typename T, typename R, typename... A>
+Callback<R(A...)>
+callback(T *obj, R (T::*method)(A...)) {
+    return Callback<R(A...)>(obj, method);
+}
+
+typedef Callback<void(int)> event_callback_t;
+
+class I2C {
+
+    int freq {100000};
+
+public:
+
+    I2C(PinName sda, PinName scl) { (void)sda; (void)scl; }
+
+    void frequency(int hz) { freq = hz; }
+
+    void lock() {}
+    void unlock() {}
+
+    int
+    write(int addr, const char *data, int len, bool repeated = false) {
+
+        (void)addr;
+        (void)repeated;
+
+        if (MockI2C::nackCount != 0) {
+
+            --MockI2C::nackCount;
+            return 1;
+        }
+
+        bool failed = false;
+        if (MockI2C::partialCount != 0 && (uint32_t)len > MockI2C::partialLength) {
+
+            --MockI2C::partialCount;
+            len = MockI2C::partialLength;
+            failed = true;
+        }
+
+        MockI2C::writes.push_back({MockI2C::now, freq, std::vector<uint8_t>(data, data + len)});
+        if (len != 0) {
+            MockI2C::outputs = data[len - 1];
+        }
+
+        // the address byte and each data byte take 9 clock cycles
+        MockI2C::now += ((len + 1) * 9 * 1000000ull) / freq;
+
+        return failed ? 1 : 0;
+    }
+
+    int
+    read(int addr, char *data, int len, bool repeated = false) {
+
+        (void)addr;
+        (void)repeated;
+
+        if (MockI2C::readFailCount != 0) {
+
+            --MockI2C::readFailCount;
+            return 1;
+        }
+
+        memset(data, MockI2C::outputs, len);
+        MockI2C::now += ((len + 1) * 9 * 1000000ull) / freq;
+
+        return 0;
+    }
+
+    int
+    transfer(int addr, const char *tx, int txLen, char *rx, int rxLen, const event_callback_t &cb,
+             int event = I2C_EVENT_TRANSFER_COMPLETE, bool repeated = false) {
+
+        (void)rx;
+        (void)rxLen;
+        (void)event;
+
+        const int result = write(addr, tx, txLen, repeated);
+        if (cb) {
+            cb((result == 0) ? I2C_EVENT_TRANSFER_COMPLETE : I2C_EVENT_ERROR);
+        }
+
+        return 0;
+    }
+};
+
+class DigitalOut {
+
+    PinName pin;
+    int value;
+
+public:
+
+    DigitalOut(PinName pin, int value = 0) : pin(pin), value(value) {}
+
+    int is_connected() const { return pin != NC; }
+    void write(int v) { value = v; }
+    int read() { return value; }
+    DigitalOut &operator=(int v) { value = v; return *this; }
+    operator int() { return value; }
+};
+
+class BusInOut {
+
+    int value {0};
+
+public:
+
+    BusInOut(PinName, PinName = NC, PinName = NC, PinName = NC, PinName = NC, PinName = NC, PinName = NC, PinName = NC) {}
+
+    void write(int v) { value = v; }
+    int read() { return value; }
+    void input() {}
+    void output() {}
+    BusInOut &operator=(int v) { value = v; return *this; }
+};
+
+class PortInOut {
+
+    int mask;
+    int value {0};
+
+public:
+
+    PortInOut(PortName port, int mask = 0xffffffff) : mask(mask) { (void)port; }
+
+    void write(int v) { value = (value & ~mask) | (v & mask); }
+    int read() { return value & mask; }
+    void input() {}
+    void output() {}
+};
+
+class SPI {
+
+public:
+
+    SPI(PinName, PinName, PinName, PinName = NC) {}
+
+    void frequency(int hz) { (void)hz; }
+    void format(int bits, int mode = 0) { (void)bits; (void)mode; }
+    int write(int v) { return v; }
+    int write(const char *tx, int txLen, char *rx, int rxLen) { (void)tx; (void)rx; (void)rxLen; return txLen; }
+    void lock() {}
+    void unlock() {}
+};
+
+class Timer {
+
+public:
+
+    void start() {}
+    void stop() {}
+    void reset() {}
+    std::chrono::microseconds elapsed_time() const { return std::chrono::microseconds(MockI2C::now); }
+};
+
+class Ticker {
+
+public:
+
+    void attach(Callback<void()> fn, std::chrono::microseconds period) { (void)fn; (void)period; }
+    void detach() {}
+};
+
+class FileHandle {
+
+public:
+
+    virtual ~FileHandle() = default;
+    virtual ssize_t write(const void *buffer, size_t length) = 0;
+    virtual ssize_t read(void *buffer, size_t length) = 0;
+};
+
+class Stream : public FileHandle {
+
+public:
+
+    Stream(const char *name = nullptr) { (void)name; }
+
+    int putc(int c) { lock(); const int result = _putc(c); unlock(); return result; }
+    int puts(const char *s) { return (int)write(s, strlen(s)); }
+
+    int
+    printf(const char *format, ...) {
+
+        va_list args;
+        va_start(args, format);
+        const int result = vprintf(format, args);
+        va_end(args);
+
+        return result;
+    }
+
+    int
+    vprintf(const char *format, va_list args) {
+
+        char buf[256];
+        const int result = vsnprintf(buf, sizeof(buf), format, args);
+        write(buf, strlen(buf));
+
+        return result;
+    }
+
+    ssize_t
+    write(const void *buffer, size_t length) override {
+
+        lock();
+        for (size_t idx = 0; idx < length; ++idx) {
+            _putc(((const char *)buffer)[idx]);
+        }
+        unlock();
+
+        return length;
+    }
+
+    ssize_t read(void *buffer, size_t length) override { (void)buffer; (void)length; return 0; }
+
+protected:
+
+    virtual int _putc(int c) = 0;
+    virtual int _getc() = 0;
+    virtual void lock() {}
+    virtual void unlock() {}
+};
+
+template <typename L>
+class ScopedLock {
+
+    L &lockable;
+
+public:
+
+    ScopedLock(L &lockable) : lockable(lockable) { lockable.lock(); }
+    ~ScopedLock() { lockable.unlock(); }
+};
+
+class NonCopyable {};
+
+} // namespace mbed
+
+namespace rtos {
+
+typedef int osPriority;
+
+constexpr osPriority    osPriorityNormal        = 0;
+constexpr osPriority    osPriorityAboveNormal   = 1;
+
+constexpr uint32_t      osFlagsWaitAny          = 0;
+constexpr uint32_t      osWaitForever           = 0xffffffff;
+constexpr uint32_t      osFlagsError            = 0x80000000;
+
+class Mutex {
+
+    std::recursive_mutex mutex;
+
+public:
+
+    void lock() { mutex.lock(); }
+    void unlock() { mutex.unlock(); }
+    bool trylock() { return mutex.try_lock(); }
+};
+
+class EventFlags {
+
+    std::atomic<uint32_t> flags {0};
+
+public:
+
+    uint32_t set(uint32_t f) { return flags |= f; }
+    uint32_t clear(uint32_t f = 0x7fffffff) { return flags &= ~f; }
+    uint32_t get() const { return flags; }
+
+    uint32_t
+    wait_any(uint32_t f, uint32_t timeout = osWaitForever, bool clear = true) {
+
+        (void)timeout;
+
+        const uint32_t result = flags & f;
+        if (clear) {
+            flags &= ~f;
+        }
+
+        return result;
+    }
+
+    uint32_t wait_all(uint32_t f, uint32_t timeout = osWaitForever, bool clear = true) { return wait_any(f, timeout, clear); }
+};
+
+/** Threads are not started (the tests do not use the asynchronous mode) */
+class Thread {
+
+public:
+
+    Thread(osPriority = osPriorityNormal, uint32_t = 4096, unsigned char * = nullptr, const char * = nullptr) {}
+
+    int start(mbed::Callback<void()> fn) { (void)fn; return 0; }
+    int join() { return 0; }
+    uint32_t flags_set(uint32_t f) { return f; }
+};
+
+namespace ThisThread {
+
+inline void sleep_for(std::chrono::milliseconds ms) { MockI2C::now += ms.count() * 1000; }
+inline uint32_t flags_wait_any(uint32_t f, bool clear = true) { (void)clear; return f; }
+inline uint32_t flags_wait_any_for(uint32_t f, std::chrono::milliseconds ms, bool clear = true) { (void)ms; (void)clear; return f; }
+inline void yield() {}
+
+} // namespace ThisThread
+
+namespace Kernel {
+
+struct Clock {
+
+    using duration = std::chrono::milliseconds;
+    using time_point = std::chrono::time_point<Clock, duration>;
+
+    static time_point now() { return time_point(duration(MockI2C::now / 1000)); }
+};
+
+} // namespace Kernel
+
+} // namespace rtos
+
+namespace events {
+
+/** Events posted to the queue run immediately, periodic events are not run */
+class EventQueue {
+
+public:
+
+    EventQueue(unsigned size = 0, unsigned char *buffer = nullptr) { (void)size; (void)buffer; }
+
+    template <typename F>
+    int call(F fn) { fn(); return 1; }
+
+    template <typename T, typename R>
+    int call(T *obj, R (T::*method)()) { (obj->*method)(); return 1; }
+
+    template <typename D, typename F>
+    int call_every(D period, F fn) { (void)period; (void)fn; return 2; }
+
+    template <typename D, typename T, typename R>
+    int call_every(D period, T *obj, R (T::*method)()) { (void)period; (void)obj; (void)method; return 2; }
+
+    template <typename D, typename F>
+    int call_in(D delay, F fn) { (void)delay; (void)fn; return 3; }
+
+    bool cancel(int id) { (void)id; return true; }
+    void dispatch_forever() {}
+};
+
+} // namespace events
+
+typedef rtos::Mutex PlatformMutex;
+
+using namespace mbed;
+using namespace rtos;
+using namespace events;
+
+#endif //__HD44780_TESTS_MBED_H__
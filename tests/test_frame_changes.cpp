@@ -0,0 +1,81 @@
+/**
+ * @file                    test_frame_changes.cpp
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Host test of the diffing of the frame in buffered mode, which only sends the cells that changed
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#include "HD44780Check.h"
+#include "HD44780Model.h"
+
+#include "HD44780LCD.h"
+
+int
+main() {
+
+    using Command = HD44780Model::Command;
+
+    MockI2C::reset();
+
+    HD44780LCD lcd(I2C_SDA, I2C_SCL);
+    HD44780Model model;
+
+    lcd.initialize();
+    lcd.enable_buffering();
+
+    // the blanks of the cleared display are not sent again
+    size_t mark = model.commands_since(0).size();
+    lcd.printf_at(0, 0, "Hello World");
+    lcd.flush();
+
+    CHECK(model.text(0x00, 16) == "Hello World     ");
+    CHECK(model.commands_since(mark) == std::vector<Command>({
+        {true, 'H'}, {true, 'e'}, {true, 'l'}, {true, 'l'}, {true, 'o'},
+        {false, 0x86},
+        {true, 'W'}, {true, 'o'}, {true, 'r'}, {true, 'l'}, {true, 'd'},
+    }));
+
+    // a single changed cell costs the address and the character
+    mark = model.log.size();
+    lcd.printf_at(0, 0, "Hello Wxrld");
+    lcd.flush();
+
+    CHECK(model.text(0x00, 16) == "Hello Wxrld     ");
+    CHECK(model.commands_since(mark) == std::vector<Command>({{false, 0x87}, {true, 'x'}}));
+
+    // writing the same characters again sends nothing
+    mark = model.log.size();
+    lcd.printf_at(0, 0, "Hello Wxrld");
+    lcd.flush();
+
+    CHECK(model.commands_since(mark).empty());
+
+    // cells that change on both rows are sent as one run per row, in order of address
+    mark = model.log.size();
+    lcd.printf_at(0, 14, "ab");
+    lcd.printf_at(1, 0, "cd");
+    lcd.flush();
+
+    CHECK(model.text(0x00, 16) == "Hello Wxrld   ab");
+    CHECK(model.text(0x40, 16) == "cd              ");
+    CHECK(model.commands_since(mark) == std::vector<Command>({
+        {false, 0x8e}, {true, 'a'}, {true, 'b'},
+        {false, 0xc0}, {true, 'c'}, {true, 'd'},
+    }));
+
+    // characters are not sent until the frame is flushed
+    mark = model.log.size();
+    lcd.printf_at(1, 4, "ef");
+    CHECK(model.commands_since(mark).empty());
+
+    lcd.flush();
+    CHECK(model.text(0x40, 16) == "cd  ef          ");
+
+    CHECK(model.timingViolations == 0);
+    CHECK(!model.is_nibble_pending());
+
+    return checkFailures;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file                    test_initialize.cpp
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Host test of the initialization sequence sent over the PC8574 backpack
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#include "HD44780Check.h"
+#include "HD44780Model.h"
+
+#include "HD44780LCD.h"
+
+int
+main() {
+
+    using Command = HD44780Model::Command;
+
+    MockI2C::reset();
+
+    HD44780LCD lcd(I2C_SDA, I2C_SCL);
+    HD44780Model model;
+
+    lcd.initialize();
+    model.replay();
+
+    // the first nibble is presented on DB4 - DB7 with RS, RW and the backlight low, and strobed by EN
+    CHECK(!MockI2C::writes.empty());
+    CHECK(MockI2C::writes[0].data == std::vector<uint8_t>({0x30, 0x34, 0x30}));
+    CHECK(MockI2C::writes[0].start >= HD44780Model::POWER_ON_TIME);
+
+    // three function sets in 8-bit mode, one in 4-bit mode, then the configuration of a 16x2 module
+    const std::vector<Command> expected = {
+        {false, 0x30},
+        {false, 0x30},
+        {false, 0x30},
+        {false, 0x20},
+        {false, 0x28},
+        {false, 0x01},
+        {false, 0x06},
+        {false, 0x0c},
+    };
+
+    CHECK(model.log == expected);
+    CHECK(model.timingViolations == 0);
+    CHECK(!model.is_nibble_pending());
+
+    CHECK(!model.eightBit);
+    CHECK(model.twoLine);
+    CHECK(model.increment);
+    CHECK(!model.displayAutoShift);
+    CHECK(model.displayControl == 0x04);
+    CHECK(model.addrCounter == 0x00);
+
+    // characters land where the geometry of the module puts them
+    lcd.printf_at(1, 3, "Hi");
+    CHECK(model.text(0x43, 2) == "Hi");
+    CHECK(model.text(0x00, 16) == std::string(16, ' '));
+    CHECK(model.timingViolations == 0);
+
+    return checkFailures;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file                    test_pager.cpp
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Host test of the pager in buffered mode, which must send the cells of a page before shifting
+ *                          the display to it
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#include "HD44780Check.h"
+#include "HD44780Model.h"
+
+#include "HD44780Pager.h"
+
+#include <algorithm>
+
+/**
+ * @brief                   Check whether a command moves the display (a shift, or returning home)
+ *
+ * @param command           Command to check
+ * @return true             If the command is one of shifting the display left or right, or returning home
+ * @return false            Otherwise
+ */
+static bool
+moves_display(const HD44780Model::Command &command) {
+    return !command.rs && (command.value == 0x18 || command.value == 0x1c || command.value == 0x02);
+}
+
+/**
+ * @brief                   Check that the commands sent to show a page write the cells before moving the display
+ *
+ * @param commands          Commands sent while showing the page
+ * @param moves             Number of commands expected to move the display
+ * @param writes            Number of characters expected to be written
+ */
+static void
+check_order(const std::vector<HD44780Model::Command> &commands, uint32_t moves, uint32_t writes) {
+
+    const auto first = std::find_if(commands.begin(), commands.end(), moves_display);
+
+    CHECK((uint32_t)std::count_if(first, commands.end(), moves_display) == moves);
+    CHECK((uint32_t)std::count_if(commands.begin(), first, [](const HD44780Model::Command &command) {
+        return command.rs;
+    }) == writes);
+
+    // nothing but moves of the display (and the position of the cursor afterwards) follows the first one
+    CHECK(std::none_of(first, commands.end(), [](const HD44780Model::Command &command) {
+        return command.rs;
+    }));
+}
+
+int
+main() {
+
+    MockI2C::reset();
+
+    // a module that is 8 columns wide holds 5 pages in each line of 40 cells
+    constexpr HD44780LCD::Geometry geometry {2, 8, {0x00, 0x40}};
+
+    HD44780LCD lcd(I2C_SDA, I2C_SCL, geometry);
+    HD44780Model model;
+
+    lcd.initialize();
+    lcd.enable_buffering();
+
+    HD44780Pager pager(lcd);
+    CHECK(pager.get_page_count() == 5);
+
+    // shifting left to the next page
+    size_t mark = model.commands_since(0).size();
+    pager.printf_at(1, 0, 0, "page-1");
+    pager.show_page(1);
+
+    check_order(model.commands_since(mark), 8, 6);
+    CHECK(model.text(0x08, 6) == "page-1");
+    CHECK(model.displayShift == -8);
+
+    // shifting right is shorter than going around the line
+    mark = model.log.size();
+    pager.printf_at(4, 1, 0, "page-4");
+    pager.show_page(4);
+
+    check_order(model.commands_since(mark), 16, 6);
+    CHECK(model.text(0x60, 6) == "page-4");
+    CHECK(model.displayShift == 8);
+
+    // returning to the first page is done by returning home
+    mark = model.log.size();
+    pager.printf_at(0, 0, 0, "page-0");
+    pager.show_page(0);
+
+    check_order(model.commands_since(mark), 1, 6);
+    CHECK(model.text(0x00, 6) == "page-0");
+    CHECK(model.displayShift == 0);
+
+    CHECK(model.timingViolations == 0);
+    CHECK(!model.is_nibble_pending());
+
+    return checkFailures;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file                    test_resync.cpp
+ * @author                  Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ *
+ * @brief                   Host test of the handling of failed I2C writes, which must never leave the LCD out of step
+ *                          with the 4-bit transfers
+ *
+ * @copyright               Copyright (c) 2023
+ *
+ */
+
+#include "HD44780Check.h"
+#include "HD44780Model.h"
+
+#include "HD44780LCD.h"
+#include "HD44780Screen.h"
+
+#include <algorithm>
+
+/**
+ * @brief                   Count the resynchronizations in a list of commands, by the function set that switches back to
+ *                          4-bit mode at the end of each (how many nibbles before it pair up depends on the state the LCD
+ *                          was left in)
+ *
+ * @param commands          Commands to search
+ * @return size_t           Number of resynchronizations
+ */
+static size_t
+count_resyncs(const std::vector<HD44780Model::Command> &commands) {
+
+    return std::count_if(commands.begin(), commands.end(), [](const HD44780Model::Command &command) {
+        return !command.rs && command.value == 0x20;
+    });
+}
+
+/** Screen sent through the precomputed outputs (encoded for the default 16x2 module and pin mapping) */
+static constexpr HD44780Screen BOOT = HD44780Screen().text(0, 0, "Booting...").text(1, 2, "fw 1.2.3").cursor_pos(1, 5)
+        .display_control(true, true, false);
+
+int
+main() {
+
+    MockI2C::reset();
+
+    HD44780LCD lcd(I2C_SDA, I2C_SCL);
+    HD44780Model model;
+
+    lcd.initialize();
+    lcd.printf_at(0, 0, "Hello");
+    CHECK(model.text(0x00, 5) == "Hello");
+
+    // a write that was not acknowledged at all latched nothing, so it is sent again without resynchronizing
+    size_t mark = model.commands_since(0).size();
+    MockI2C::nackCount = 1;
+    lcd.printf_at(1, 0, "World");
+
+    CHECK(model.text(0x40, 5) == "World");
+    CHECK(count_resyncs(model.commands_since(mark)) == 0);
+    CHECK(!model.is_nibble_pending());
+
+    // a write that failed after a single nibble was strobed leaves the LCD waiting for the lower nibble, it is not sent
+    // again and the LCD is resynchronized instead, with the text on it restored
+    mark = model.log.size();
+    MockI2C::partialCount = 1;
+    MockI2C::partialLength = 4;
+    lcd.printf_at(0, 6, "!");
+
+    CHECK(count_resyncs(model.commands_since(mark)) == 1);
+    CHECK(!model.is_nibble_pending());
+    CHECK(!model.eightBit);
+    CHECK(model.text(0x00, 16) == "Hello !         ");
+    CHECK(model.text(0x40, 16) == "World           ");
+
+    // later writes land where they should
+    lcd.printf_at(0, 7, "ok");
+    CHECK(model.text(0x00, 16) == "Hello !ok       ");
+
+    // a bus that keeps failing stops being retried, and is resynchronized once it works again
+    mark = model.log.size();
+    MockI2C::nackCount = HD44780LCD_I2C_RETRIES + 1;
+    lcd.printf_at(1, 6, "again");
+
+    CHECK(MockI2C::nackCount == 0);
+    CHECK(count_resyncs(model.commands_since(mark)) == 1);
+    CHECK(!model.is_nibble_pending());
+    CHECK(model.text(0x40, 16) == "World again     ");
+
+    // a precomputed screen that failed partway is recovered like any other write, with the screen restored
+    mark = model.log.size();
+    MockI2C::partialCount = 1;
+    MockI2C::partialLength = 40;
+    lcd.show_screen(BOOT);
+
+    CHECK(count_resyncs(model.commands_since(mark)) == 1);
+    CHECK(!model.is_nibble_pending());
+    CHECK(model.text(0x00, 16) == "Booting...      ");
+    CHECK(model.text(0x40, 16) == "  fw 1.2.3      ");
+    CHECK(model.addrCounter == 0x45);
+
+    CHECK(model.timingViolations == 0);
+
+    return checkFailures;
+}